@@ -72,6 +72,7 @@
 #include "libavutil/dict.h"
 #include "libavutil/mem.h"
 #include "libavutil/time.h"
+#include "libavutil/trace.h"
 
 #include "libavformat/avformat.h"
 
@@ -141,6 +142,14 @@ static atomic_int transcode_init_done = 0;
 static volatile int ffmpeg_exited = 0;
 static int64_t copy_ts_first_pts = AV_NOPTS_VALUE;
 
+// FrameData attached to every packet and frame, reused to avoid allocating
+// it anew for each of them
+static AVBufferPool *frame_data_pool;
+// number of FrameData taken from the pool and allocated by it, reported
+// with -benchmark to show that allocations stop once the pool is warm
+static atomic_uint_least64_t frame_data_nb_used;
+static atomic_uint_least64_t frame_data_nb_allocated;
+
 static void
 sigterm_handler(int sig)
 {
@@ -315,6 +324,9 @@ static void ffmpeg_cleanup(int ret)
     if (do_benchmark) {
         int64_t maxrss = getmaxrss() / 1024;
         av_log(NULL, AV_LOG_INFO, "bench: maxrss=%"PRId64"KiB\n", maxrss);
+        av_log(NULL, AV_LOG_INFO, "bench: framedata used=%"PRIu64" allocated=%"PRIu64"\n",
+               (uint64_t)atomic_load(&frame_data_nb_used),
+               (uint64_t)atomic_load(&frame_data_nb_allocated));
     }
 
     for (int i = 0; i < nb_filtergraphs; i++)
@@ -331,6 +343,16 @@ static void ffmpeg_cleanup(int ret)
         dec_free(&decoders[i]);
     av_freep(&decoders);
 
+    if (trace_events_file) {
+        int err = av_trace_write_json(trace_events_file);
+        if (err < 0)
+            av_log(NULL, AV_LOG_ERROR, "Error writing trace events to '%s': %s\n",
+                   trace_events_file, av_err2str(err));
+        av_freep(&trace_events_file);
+    }
+    av_buffer_unref(&thread_pool);
+    av_buffer_pool_uninit(&frame_data_pool);
+
     if (vstats_file) {
         if (fclose(vstats_file))
             av_log(NULL, AV_LOG_ERROR,
@@ -405,6 +427,24 @@ static void frame_data_free(void *opaque, uint8_t *data)
     av_free(data);
 }
 
+static AVBufferRef *frame_data_alloc(size_t size)
+{
+    AVBufferRef *buf;
+    FrameData *fd;
+
+    fd = av_mallocz(size);
+    if (!fd)
+        return NULL;
+
+    buf = av_buffer_create((uint8_t *)fd, size, frame_data_free, NULL, 0);
+    if (!buf)
+        av_freep(&fd);
+    else
+        atomic_fetch_add_explicit(&frame_data_nb_allocated, 1, memory_order_relaxed);
+
+    return buf;
+}
+
 static int frame_data_ensure(AVBufferRef **dst, int writable)
 {
     AVBufferRef *src = *dst;
@@ -412,17 +452,16 @@ static int frame_data_ensure(AVBufferRef **dst, int writable)
     if (!src || (writable && !av_buffer_is_writable(src))) {
         FrameData *fd;
 
-        fd = av_mallocz(sizeof(*fd));
-        if (!fd)
-            return AVERROR(ENOMEM);
-
-        *dst = av_buffer_create((uint8_t *)fd, sizeof(*fd),
-                                frame_data_free, NULL, 0);
+        *dst = av_buffer_pool_get(frame_data_pool);
         if (!*dst) {
             av_buffer_unref(&src);
-            av_freep(&fd);
             return AVERROR(ENOMEM);
         }
+        fd = (FrameData *)(*dst)->data;
+        atomic_fetch_add_explicit(&frame_data_nb_used, 1, memory_order_relaxed);
+
+        // a reused FrameData may still hold the parameters from its last use
+        avcodec_parameters_free(&fd->par_enc);
 
         if (src) {
             const FrameData *fd_src = (const FrameData *)src->data;
@@ -446,6 +485,8 @@ static int frame_data_ensure(AVBufferRef **dst, int writable)
 
             av_buffer_unref(&src);
         } else {
+            memset(fd, 0, sizeof(*fd));
+
             fd->dec.frame_num = UINT64_MAX;
             fd->dec.pts       = AV_NOPTS_VALUE;
 
@@ -552,7 +593,36 @@ void update_benchmark(const char *fmt, ...)
     }
 }
 
-static void print_report(int is_last_report, int64_t timer_start, int64_t cur_time, int64_t pts)
+static void print_latency_stats(AVBPrint *bp)
+{
+    static const char *desc[] = {
+        [LATENCY_PROBE_DEMUX]       = "demux",
+        [LATENCY_PROBE_DEC_PRE]     = "dec_pre",
+        [LATENCY_PROBE_DEC_POST]    = "dec_post",
+        [LATENCY_PROBE_FILTER_PRE]  = "filter_pre",
+        [LATENCY_PROBE_FILTER_POST] = "filter_post",
+        [LATENCY_PROBE_ENC_PRE]     = "enc_pre",
+        [LATENCY_PROBE_ENC_POST]    = "enc_post",
+    };
+
+    for (OutputStream *ost = ost_iter(NULL); ost; ost = ost_iter(ost)) {
+        uint64_t count = atomic_load(&ost->latency_count);
+
+        if (!count)
+            continue;
+
+        av_bprintf(bp, "stream_%d_%d_latency_us=%"PRId64"\n",
+                   ost->file->index, ost->index,
+                   (int64_t)atomic_load(&ost->latency_total) / (int64_t)count);
+        for (int i = 0; i < LATENCY_PROBE_NB; i++)
+            av_bprintf(bp, "stream_%d_%d_latency_%s_us=%"PRId64"\n",
+                       ost->file->index, ost->index, desc[i],
+                       (int64_t)atomic_load(&ost->latency_stage[i]) / (int64_t)count);
+    }
+}
+
+static void print_report(Scheduler *sch, int is_last_report,
+                         int64_t timer_start, int64_t cur_time, int64_t pts)
 {
     AVBPrint buf, buf_script;
     int64_t total_size = of_filesize(output_files[0]);
@@ -585,7 +655,7 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
 
     vid = 0;
     av_bprint_init(&buf, 0, AV_BPRINT_SIZE_AUTOMATIC);
-    av_bprint_init(&buf_script, 0, AV_BPRINT_SIZE_AUTOMATIC);
+    av_bprint_init(&buf_script, 0, AV_BPRINT_SIZE_UNLIMITED);
 
     for (OutputStream *ost = ost_iter(NULL); ost; ost = ost_iter(ost)) {
         const float q = ost->enc ? atomic_load(&ost->quality) / (float) FF_QP2LAMBDA : -1;
@@ -698,6 +768,10 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
     av_bprint_finalize(&buf, NULL);
 
     if (progress_avio) {
+        if (sched_stats) {
+            sch_print_stats(sch, &buf_script);
+            print_latency_stats(&buf_script);
+        }
         av_bprintf(&buf_script, "progress=%s\n",
                    is_last_report ? "end" : "continue");
         avio_write(progress_avio, buf_script.str,
@@ -897,7 +971,7 @@ static int transcode(Scheduler *sch)
                 break;
 
         /* dump report by using the output first video and audio streams */
-        print_report(0, timer_start, cur_time, transcode_ts);
+        print_report(sch, 0, timer_start, cur_time, transcode_ts);
     }
 
     ret = sch_stop(sch, &transcode_ts);
@@ -911,7 +985,7 @@ static int transcode(Scheduler *sch)
     term_exit();
 
     /* dump report by using the first video and audio streams */
-    print_report(1, timer_start, av_gettime_relative(), transcode_ts);
+    print_report(sch, 1, timer_start, av_gettime_relative(), transcode_ts);
 
     return ret;
 }
@@ -981,8 +1055,9 @@ int main(int argc, char **argv)
 
     show_banner(argc, argv, options);
 
-    sch = sch_alloc();
-    if (!sch) {
+    sch             = sch_alloc();
+    frame_data_pool = av_buffer_pool_init(sizeof(FrameData), frame_data_alloc);
+    if (!sch || !frame_data_pool) {
         ret = AVERROR(ENOMEM);
         goto finish;
     }
@@ -166,6 +166,7 @@ typedef struct OptionsContext {
     float readrate;
     float readrate_catchup;
     double readrate_initial_burst;
+    int64_t readahead_size;
     int accurate_seek;
     int thread_queue_size;
     int input_sync_ref;
@@ -178,6 +179,7 @@ typedef struct OptionsContext {
     SpecifierOptList hwaccel_output_formats;
     SpecifierOptList autorotate;
     SpecifierOptList apply_cropping;
+    SpecifierOptList dec_instances;
 
     /* output options */
     StreamMap *stream_maps;
@@ -239,6 +241,8 @@ typedef struct OptionsContext {
     SpecifierOptList canvas_sizes;
     SpecifierOptList pass;
     SpecifierOptList passlogfiles;
+    SpecifierOptList enc_chunks;
+    SpecifierOptList enc_chunk_frames;
     SpecifierOptList max_muxing_queue_size;
     SpecifierOptList muxing_queue_data_threshold;
     SpecifierOptList guess_layout_max;
@@ -439,6 +443,10 @@ typedef struct DecoderOpts {
     // Either forced (when DECODER_FLAG_FRAMERATE_FORCED is set) or
     // estimated (otherwise) video framerate.
     AVRational                  framerate;
+
+    // number of decoder instances to decode packets with round-robin,
+    // only used for intra-only video
+    int                         instances;
 } DecoderOpts;
 
 typedef struct Decoder {
@@ -629,6 +637,11 @@ typedef struct OutputStream {
     int bitexact;
     int bits_per_raw_sample;
 
+    // number of encoder instances encoding consecutive chunks of
+    // enc_chunk_frames frames in parallel, 0 to disable chunked encoding
+    int enc_chunks;
+    int enc_chunk_frames;
+
     AVRational frame_aspect_ratio;
 
     KeyframeForceCtx kf;
@@ -646,6 +659,13 @@ typedef struct OutputStream {
     // number of packets send to the muxer
     atomic_uint_least64_t packets_written;
 
+    // with -sched_stats: number of packets sent to the muxer that carry
+    // latency probes, the sum of their total latencies, and the sums of the
+    // times from each probe to the next one, all in microseconds
+    atomic_uint_least64_t latency_count;
+    atomic_int_least64_t  latency_total;
+    atomic_int_least64_t  latency_stage[LATENCY_PROBE_NB];
+
     /* packet quality factor */
     atomic_int quality;
 
@@ -731,6 +751,7 @@ extern int exit_on_error;
 extern int abort_on_flags;
 extern int print_stats;
 extern int64_t stats_period;
+extern int sched_stats;
 extern int stdin_interaction;
 extern AVIOContext *progress_avio;
 extern float max_error_rate;
@@ -741,6 +762,8 @@ extern int filter_buffered_frames;
 extern int vstats_version;
 extern int print_graphs;
 extern char *print_graphs_file;
+extern char *trace_events_file;
+extern AVBufferRef *thread_pool;
 extern char *print_graphs_format;
 extern int auto_conversion_filters;
 
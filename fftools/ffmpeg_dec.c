@@ -28,6 +28,7 @@
 #include "libavutil/pixdesc.h"
 #include "libavutil/pixfmt.h"
 #include "libavutil/stereo3d.h"
+#include "libavutil/thread.h"
 #include "libavutil/time.h"
 #include "libavutil/timestamp.h"
 
@@ -35,6 +36,7 @@
 #include "libavcodec/codec.h"
 
 #include "ffmpeg.h"
+#include "thread_queue.h"
 
 typedef struct DecoderPriv {
     Decoder             dec;
@@ -54,6 +56,10 @@ typedef struct DecoderPriv {
     int                 flags;
     int                 apply_cropping;
 
+    // number of decoder instances decoding packets round-robin, 0 when
+    // dec_ctx decodes everything itself
+    int                 nb_instances;
+
     enum AVPixelFormat  hwaccel_pix_fmt;
     enum HWAccelID      hwaccel_id;
     enum AVHWDeviceType hwaccel_device_type;
@@ -109,10 +115,35 @@ static DecoderPriv *dp_from_dec(Decoder *d)
     return (DecoderPriv*)d;
 }
 
+// one of several decoder instances, see DecoderPriv.nb_instances
+typedef struct DecInstance {
+    DecoderPriv     *dp;
+    AVCodecContext  *dec_ctx;
+
+    // decoder thread -> instance thread
+    ThreadQueue     *queue_in;
+    // instance thread -> decoder thread; the frames decoded from each packet,
+    // followed by an empty frame with NULL opaque marking the end of its
+    // output, empty frames with opaque set carry decoding errors
+    ThreadQueue     *queue_out;
+
+    pthread_t        thread;
+    int              thread_started;
+
+    // written by the instance thread before it finishes queue_out
+    int              ret;
+} DecInstance;
+
 // data that is local to the decoder thread and not visible outside of it
 typedef struct DecThreadContext {
     AVFrame         *frame;
     AVPacket        *pkt;
+
+    // packet n is decoded by instances[n % nb_instances]
+    DecInstance     *instances;
+    int           nb_instances;
+    uint64_t         pkts_sent;
+    uint64_t         pkts_done;
 } DecThreadContext;
 
 void dec_free(Decoder **pdec)
@@ -694,7 +725,74 @@ static int transcode_subtitles(DecoderPriv *dp, const AVPacket *pkt,
     return process_subtitle(dp, frame);
 }
 
-static int packet_decode(DecoderPriv *dp, AVPacket *pkt, AVFrame *frame)
+/* Process a decoded audio/video frame and send it to the decoder outputs.
+ * fd must be the frame's FrameData, with the fields describing the
+ * decoding itself filled in by the caller. */
+static int frame_output(DecoderPriv *dp, AVFrame *frame, FrameData *fd)
+{
+    AVCodecContext *dec = dp->dec_ctx;
+    unsigned outputs_mask = 1;
+    int ret;
+
+    if (frame->decode_error_flags || (frame->flags & AV_FRAME_FLAG_CORRUPT)) {
+        av_log(dp, exit_on_error ? AV_LOG_FATAL : AV_LOG_WARNING,
+               "corrupt decoded frame\n");
+        if (exit_on_error)
+            return AVERROR_INVALIDDATA;
+    }
+
+    fd->dec.pts = frame->pts;
+    fd->dec.tb  = dec->pkt_timebase;
+
+    frame->time_base = dec->pkt_timebase;
+
+    if (dec->codec_type == AVMEDIA_TYPE_AUDIO) {
+        dp->dec.samples_decoded += frame->nb_samples;
+
+        audio_ts_process(dp, frame);
+    } else {
+        ret = video_frame_process(dp, frame, &outputs_mask);
+        if (ret < 0) {
+            av_log(dp, AV_LOG_FATAL,
+                   "Error while processing the decoded data\n");
+            return ret;
+        }
+    }
+
+    dp->dec.frames_decoded++;
+
+    for (int i = 0; i < stdc_count_ones(outputs_mask); i++) {
+        AVFrame *to_send = frame;
+        int pos;
+
+        av_assert0(outputs_mask);
+        pos = stdc_trailing_zeros(outputs_mask);
+        outputs_mask &= ~(1U << pos);
+
+        // this is not the last output and sch_dec_send() consumes the frame
+        // given to it, so make a temporary reference
+        if (outputs_mask) {
+            to_send = dp->frame_tmp_ref;
+            ret = av_frame_ref(to_send, frame);
+            if (ret < 0)
+                return ret;
+        }
+
+        ret = sch_dec_send(dp->sch, dp->sch_idx, pos, to_send);
+        if (ret < 0) {
+            av_frame_unref(to_send);
+            return ret == AVERROR_EOF ? AVERROR_EXIT : ret;
+        }
+    }
+
+    return 0;
+}
+
+static int instances_send_packet(DecoderPriv *dp, DecThreadContext *dt,
+                                 AVPacket *pkt, AVFrame *frame);
+
+static int packet_decode(DecoderPriv *dp, DecThreadContext *dt,
+                         AVPacket *pkt, AVFrame *frame)
 {
     AVCodecContext *dec = dp->dec_ctx;
     const char *type_desc = av_get_media_type_string(dec->codec_type);
@@ -721,6 +819,9 @@ static int packet_decode(DecoderPriv *dp, AVPacket *pkt, AVFrame *frame)
         fd->wallclock[LATENCY_PROBE_DEC_PRE] = av_gettime_relative();
     }
 
+    if (dt->nb_instances)
+        return instances_send_packet(dp, dt, pkt, frame);
+
     ret = avcodec_send_packet(dec, pkt);
     if (ret < 0 && !(ret == AVERROR_EOF && !pkt)) {
         // In particular, we don't expect AVERROR(EAGAIN), because we read all
@@ -743,7 +844,6 @@ static int packet_decode(DecoderPriv *dp, AVPacket *pkt, AVFrame *frame)
 
     while (1) {
         FrameData *fd;
-        unsigned outputs_mask = 1;
 
         av_frame_unref(frame);
 
@@ -766,66 +866,279 @@ static int packet_decode(DecoderPriv *dp, AVPacket *pkt, AVFrame *frame)
             continue;
         }
 
-        if (frame->decode_error_flags || (frame->flags & AV_FRAME_FLAG_CORRUPT)) {
-            av_log(dp, exit_on_error ? AV_LOG_FATAL : AV_LOG_WARNING,
-                   "corrupt decoded frame\n");
-            if (exit_on_error)
-                return AVERROR_INVALIDDATA;
-        }
-
         fd      = frame_data(frame);
         if (!fd) {
             av_frame_unref(frame);
             return AVERROR(ENOMEM);
         }
-        fd->dec.pts                 = frame->pts;
-        fd->dec.tb                  = dec->pkt_timebase;
         fd->dec.frame_num           = dec->frame_num - 1;
         fd->bits_per_raw_sample     = dec->bits_per_raw_sample;
 
         fd->wallclock[LATENCY_PROBE_DEC_POST] = av_gettime_relative();
 
-        frame->time_base = dec->pkt_timebase;
+        ret = frame_output(dp, frame, fd);
+        if (ret < 0)
+            return ret;
+    }
+}
 
-        if (dec->codec_type == AVMEDIA_TYPE_AUDIO) {
-            dp->dec.samples_decoded += frame->nb_samples;
+static int instance_send_error(DecInstance *di, AVFrame *frame, int err)
+{
+    frame->opaque = (void*)(intptr_t)err;
+    return tq_send(di->queue_out, 0, frame);
+}
+
+static void *instance_thread(void *arg)
+{
+    DecInstance *di = arg;
+    DecoderPriv *dp = di->dp;
+    AVPacket   *pkt = av_packet_alloc();
+    AVFrame  *frame = av_frame_alloc();
+    int ret = 0;
+
+    if (!pkt || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto finish;
+    }
+
+    while (1) {
+        int stream_idx;
+
+        ret = tq_receive(di->queue_in, &stream_idx, pkt);
+        if (ret < 0)
+            break;
 
-            audio_ts_process(dp, frame);
+        // an empty packet requests a flush
+        if (!pkt->buf && !pkt->side_data_elems) {
+            avcodec_flush_buffers(di->dec_ctx);
         } else {
-            ret = video_frame_process(dp, frame, &outputs_mask);
+            ret = avcodec_send_packet(di->dec_ctx, pkt);
+            av_packet_unref(pkt);
             if (ret < 0) {
-                av_log(dp, AV_LOG_FATAL,
-                       "Error while processing the decoded data\n");
-                return ret;
+                av_log(dp, AV_LOG_ERROR, "Error submitting packet to decoder: %s\n",
+                       av_err2str(ret));
+                ret = instance_send_error(di, frame, ret);
+                if (ret < 0)
+                    goto finish;
             }
-        }
 
-        dp->dec.frames_decoded++;
+            while (1) {
+                FrameData *fd;
 
-        for (int i = 0; i < stdc_count_ones(outputs_mask); i++) {
-            AVFrame *to_send = frame;
-            int pos;
+                ret = avcodec_receive_frame(di->dec_ctx, frame);
+                if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+                    break;
+                else if (ret < 0) {
+                    av_log(dp, AV_LOG_ERROR, "Decoding error: %s\n", av_err2str(ret));
+                    ret = instance_send_error(di, frame, ret);
+                    if (ret < 0)
+                        goto finish;
+                    continue;
+                }
 
-            av_assert0(outputs_mask);
-            pos = stdc_trailing_zeros(outputs_mask);
-            outputs_mask &= ~(1U << pos);
+                fd = frame_data(frame);
+                if (!fd) {
+                    av_frame_unref(frame);
+                    ret = AVERROR(ENOMEM);
+                    goto finish;
+                }
+                fd->bits_per_raw_sample               = di->dec_ctx->bits_per_raw_sample;
+                fd->wallclock[LATENCY_PROBE_DEC_POST] = av_gettime_relative();
 
-            // this is not the last output and sch_dec_send() consumes the frame
-            // given to it, so make a temporary reference
-            if (outputs_mask) {
-                to_send = dp->frame_tmp_ref;
-                ret = av_frame_ref(to_send, frame);
-                if (ret < 0)
-                    return ret;
+                ret = tq_send(di->queue_out, 0, frame);
+                if (ret < 0) {
+                    av_frame_unref(frame);
+                    goto finish;
+                }
             }
+        }
 
-            ret = sch_dec_send(dp->sch, dp->sch_idx, pos, to_send);
-            if (ret < 0) {
-                av_frame_unref(to_send);
-                return ret == AVERROR_EOF ? AVERROR_EXIT : ret;
-            }
+        // mark the end of the output for this packet
+        ret = tq_send(di->queue_out, 0, frame);
+        if (ret < 0)
+            goto finish;
+    }
+
+finish:
+    di->ret = ret == AVERROR_EOF ? 0 : ret;
+    tq_receive_finish(di->queue_in, 0);
+    tq_send_finish(di->queue_out, 0);
+
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+
+    return NULL;
+}
+
+static int instance_ctx_alloc(DecoderPriv *dp, AVCodecContext **pctx)
+{
+    const AVCodecContext *tmpl = dp->dec_ctx;
+    AVCodecParameters *par;
+    AVCodecContext *dec_ctx;
+    int ret;
+
+    *pctx = dec_ctx = avcodec_alloc_context3(tmpl->codec);
+    if (!dec_ctx)
+        return AVERROR(ENOMEM);
+
+    ret = av_opt_copy(dec_ctx, tmpl);
+    if (ret < 0)
+        return ret;
+    if (tmpl->codec->priv_class) {
+        ret = av_opt_copy(dec_ctx->priv_data, tmpl->priv_data);
+        if (ret < 0)
+            return ret;
+    }
+
+    par = avcodec_parameters_alloc();
+    if (!par)
+        return AVERROR(ENOMEM);
+    ret = avcodec_parameters_from_context(par, tmpl);
+    if (ret >= 0)
+        ret = avcodec_parameters_to_context(dec_ctx, par);
+    avcodec_parameters_free(&par);
+    if (ret < 0)
+        return ret;
+
+    dec_ctx->pkt_timebase = tmpl->pkt_timebase;
+
+    if (tmpl->thread_pool &&
+        !(dec_ctx->thread_pool = av_buffer_ref(tmpl->thread_pool)))
+        return AVERROR(ENOMEM);
+
+    return avcodec_open2(dec_ctx, dec_ctx->codec, NULL);
+}
+
+static int instances_init(DecoderPriv *dp, DecThreadContext *dt)
+{
+    int ret;
+
+    dt->instances = av_calloc(dp->nb_instances, sizeof(*dt->instances));
+    if (!dt->instances)
+        return AVERROR(ENOMEM);
+    dt->nb_instances = dp->nb_instances;
+
+    for (int i = 0; i < dt->nb_instances; i++) {
+        DecInstance *di = &dt->instances[i];
+
+        di->dp = dp;
+
+        ret = instance_ctx_alloc(dp, &di->dec_ctx);
+        if (ret < 0) {
+            av_log(dp, AV_LOG_ERROR, "Error opening decoder instance %d: %s\n",
+                   i, av_err2str(ret));
+            return ret;
         }
+
+        di->queue_in  = tq_alloc(1, 2, THREAD_QUEUE_PACKETS);
+        di->queue_out = tq_alloc(1, 8, THREAD_QUEUE_FRAMES);
+        if (!di->queue_in || !di->queue_out)
+            return AVERROR(ENOMEM);
+
+        ret = pthread_create(&di->thread, NULL, instance_thread, di);
+        if (ret)
+            return AVERROR(ret);
+        di->thread_started = 1;
     }
+
+    av_log(dp, AV_LOG_VERBOSE, "Decoding with %d decoder instances\n",
+           dt->nb_instances);
+
+    return 0;
+}
+
+/* Pass on the output of the oldest packet still being decoded. */
+static int instance_collect(DecoderPriv *dp, DecThreadContext *dt, AVFrame *frame)
+{
+    DecInstance *di = &dt->instances[dt->pkts_done % dt->nb_instances];
+    int stream_idx, ret;
+
+    while (1) {
+        FrameData *fd;
+
+        av_frame_unref(frame);
+
+        ret = tq_receive(di->queue_out, &stream_idx, frame);
+        // the instance thread only stops sending on failure
+        if (ret < 0)
+            return di->ret < 0 ? di->ret : AVERROR_BUG;
+
+        if (!frame->buf[0]) {
+            int err = (intptr_t)frame->opaque;
+
+            frame->opaque = NULL;
+            if (!err)
+                break;
+
+            dp->dec.decode_errors++;
+            if (exit_on_error)
+                return err;
+            continue;
+        }
+
+        fd = frame_data(frame);
+        if (!fd) {
+            av_frame_unref(frame);
+            return AVERROR(ENOMEM);
+        }
+        fd->dec.frame_num = dp->dec.frames_decoded;
+
+        ret = frame_output(dp, frame, fd);
+        if (ret < 0)
+            return ret;
+    }
+
+    dt->pkts_done++;
+
+    return 0;
+}
+
+static int instance_send(DecoderPriv *dp, DecThreadContext *dt,
+                         AVPacket *pkt, AVFrame *frame)
+{
+    DecInstance *di = &dt->instances[dt->pkts_sent % dt->nb_instances];
+    int ret;
+
+    // keep at most two packets in flight per instance, so that sending
+    // never blocks on an instance whose output is not being collected
+    if (dt->pkts_sent - dt->pkts_done >= 2 * dt->nb_instances) {
+        ret = instance_collect(dp, dt, frame);
+        if (ret < 0)
+            return ret;
+    }
+
+    ret = tq_send(di->queue_in, 0, pkt);
+    if (ret < 0) {
+        av_packet_unref(pkt);
+        return ret == AVERROR_EOF ? (di->ret < 0 ? di->ret : AVERROR_BUG) : ret;
+    }
+    dt->pkts_sent++;
+
+    return 0;
+}
+
+static int instances_send_packet(DecoderPriv *dp, DecThreadContext *dt,
+                                 AVPacket *pkt, AVFrame *frame)
+{
+    int ret;
+
+    if (pkt)
+        return instance_send(dp, dt, pkt, frame);
+
+    // flush all instances and pass on everything still in flight
+    for (int i = 0; i < dt->nb_instances; i++) {
+        av_packet_unref(dt->pkt);
+        ret = instance_send(dp, dt, dt->pkt, frame);
+        if (ret < 0)
+            return ret;
+    }
+    while (dt->pkts_done < dt->pkts_sent) {
+        ret = instance_collect(dp, dt, frame);
+        if (ret < 0)
+            return ret;
+    }
+
+    return AVERROR_EOF;
 }
 
 static int dec_open(DecoderPriv *dp, AVDictionary **dec_opts,
@@ -883,6 +1196,20 @@ static void dec_thread_set_name(const DecoderPriv *dp)
 
 static void dec_thread_uninit(DecThreadContext *dt)
 {
+    for (int i = 0; i < dt->nb_instances; i++) {
+        DecInstance *di = &dt->instances[i];
+
+        if (di->thread_started) {
+            tq_send_finish(di->queue_in, 0);
+            tq_receive_finish(di->queue_out, 0);
+            pthread_join(di->thread, NULL);
+        }
+        tq_free(&di->queue_in);
+        tq_free(&di->queue_out);
+        avcodec_free_context(&di->dec_ctx);
+    }
+    av_freep(&dt->instances);
+
     av_packet_free(&dt->pkt);
     av_frame_free(&dt->frame);
 
@@ -949,7 +1276,13 @@ static int decoder_thread(void *arg)
                 goto finish;
         }
 
-        ret = packet_decode(dp, have_data ? dt.pkt : NULL, dt.frame);
+        if (dp->nb_instances && !dt.nb_instances) {
+            ret = instances_init(dp, &dt);
+            if (ret < 0)
+                goto finish;
+        }
+
+        ret = packet_decode(dp, &dt, have_data ? dt.pkt : NULL, dt.frame);
 
         av_packet_unref(dt.pkt);
         av_frame_unref(dt.frame);
@@ -1590,6 +1923,24 @@ static int dec_open(DecoderPriv *dp, AVDictionary **dec_opts,
     if (ret < 0)
         return ret;
 
+    if (o->instances > 1) {
+        const AVCodecDescriptor *desc = avcodec_descriptor_get(codec->id);
+
+        if (codec->type != AVMEDIA_TYPE_VIDEO ||
+            !desc || !(desc->props & AV_CODEC_PROP_INTRA_ONLY) ||
+            (codec->capabilities & AV_CODEC_CAP_DELAY) ||
+            dp->hwaccel_id != HWACCEL_NONE) {
+            av_log(dp, AV_LOG_WARNING, "Multiple decoder instances are only "
+                   "supported for software decoding of intra-only video, "
+                   "using a single decoder\n");
+        } else {
+            dp->nb_instances = o->instances;
+            // every instance must output the frame for a packet before
+            // receiving the next one, so frame threading cannot be used
+            dp->dec_ctx->thread_type &= ~FF_THREAD_FRAME;
+        }
+    }
+
     dp->dec_ctx->flags |= AV_CODEC_FLAG_COPY_OPAQUE;
     if (o->flags & DECODER_FLAG_BITEXACT)
         dp->dec_ctx->flags |= AV_CODEC_FLAG_BITEXACT;
@@ -1598,6 +1949,12 @@ static int dec_open(DecoderPriv *dp, AVDictionary **dec_opts,
     dp->apply_cropping          = dp->dec_ctx->apply_cropping;
     dp->dec_ctx->apply_cropping = 0;
 
+    if (thread_pool) {
+        dp->dec_ctx->thread_pool = av_buffer_ref(thread_pool);
+        if (!dp->dec_ctx->thread_pool)
+            return AVERROR(ENOMEM);
+    }
+
     if ((ret = avcodec_open2(dp->dec_ctx, codec, NULL)) < 0) {
         av_log(dp, AV_LOG_ERROR, "Error while opening decoder: %s\n",
                av_err2str(ret));
@@ -32,6 +32,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/parseutils.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/thread.h"
 #include "libavutil/time.h"
 #include "libavutil/timestamp.h"
 
@@ -136,6 +137,9 @@ typedef struct Demuxer {
     double                readrate_initial_burst;
     float                 readrate_catchup;
 
+    // maximum number of bytes to read ahead of the demuxer, 0 to disable
+    int64_t               readahead_size;
+
     Scheduler            *sch;
 
     AVPacket             *pkt_heartbeat;
@@ -145,11 +149,46 @@ typedef struct Demuxer {
     int                   nb_streams_finished;
 } Demuxer;
 
+typedef struct PrefetchEntry {
+    // in AV_TIME_BASE
+    int64_t ts;
+    int64_t pos;
+    int     size;
+    // sum of the sizes of all the preceding entries
+    int64_t offset;
+} PrefetchEntry;
+
+// reads the data of the upcoming packets ahead of the demuxer, in the order
+// given by the index, so that it is already cached when the demuxer needs it
+typedef struct Prefetcher {
+    Demuxer          *d;
+    AVIOContext      *pb;
+    uint8_t          *buf;
+
+    // index entries of all used streams, sorted by timestamp
+    PrefetchEntry    *entries;
+    size_t         nb_entries;
+
+    // current and maximum number of bytes to read ahead
+    int64_t           window;
+    int64_t           window_max;
+
+    pthread_t         thread;
+    pthread_mutex_t   lock;
+    pthread_cond_t    cond;
+
+    // protected by lock
+    int64_t           demux_ts;
+    int               finish;
+} Prefetcher;
+
 typedef struct DemuxThreadContext {
     // packet used for reading from the demuxer
     AVPacket *pkt_demux;
     // packet for reading from BSFs
     AVPacket *pkt_bsf;
+
+    Prefetcher *prefetch;
 } DemuxThreadContext;
 
 static DemuxStream *ds_from_ist(InputStream *ist)
@@ -683,6 +722,252 @@ static void discard_unused_programs(InputFile *ifile)
     }
 }
 
+#define PREFETCH_BATCH_SIZE (1 << 20)
+// gaps between entries smaller than this are read through
+#define PREFETCH_MAX_GAP     (64 << 10)
+
+static int prefetch_entry_cmp(const void *a, const void *b)
+{
+    const PrefetchEntry *e1 = a, *e2 = b;
+
+    if (e1->ts != e2->ts)
+        return FFDIFFSIGN(e1->ts, e2->ts);
+    return FFDIFFSIGN(e1->pos, e2->pos);
+}
+
+// index of the first entry after the one the demuxer read last
+static size_t prefetch_find(const Prefetcher *p, int64_t ts)
+{
+    size_t lo = 0, hi = p->nb_entries;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (p->entries[mid].ts <= ts)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static int prefetch_read(Prefetcher *p, size_t start, size_t end)
+{
+    while (start < end) {
+        int64_t pos  = p->entries[start].pos;
+        int64_t size = p->entries[start].size;
+
+        // merge the following entries that are close enough
+        for (start++; start < end; start++) {
+            const PrefetchEntry *e = &p->entries[start];
+            if (e->pos < pos || e->pos > pos + size + PREFETCH_MAX_GAP)
+                break;
+            size = FFMAX(size, e->pos + e->size - pos);
+        }
+
+        if (avio_seek(p->pb, pos, SEEK_SET) < 0)
+            return AVERROR(EIO);
+        while (size > 0) {
+            int ret = avio_read(p->pb, p->buf, FFMIN(size, PREFETCH_BATCH_SIZE));
+            if (ret <= 0)
+                return ret < 0 ? ret : AVERROR_EOF;
+            size -= ret;
+        }
+    }
+
+    return 0;
+}
+
+static void *prefetch_thread(void *arg)
+{
+    Prefetcher *p = arg;
+    size_t next = 0, last = 0;
+    int ret;
+
+    ff_thread_setname("prefetch");
+
+    pthread_mutex_lock(&p->lock);
+    while (!p->finish) {
+        size_t cur = prefetch_find(p, p->demux_ts), end;
+
+        if (cur < last) {
+            // the demuxer went back, e.g. when looping
+            next = cur;
+        } else if (next < cur) {
+            // the demuxer caught up, read further ahead from now on
+            if (next)
+                p->window = FFMIN(2 * p->window, p->window_max);
+            next = cur;
+        }
+        last = cur;
+
+        if (next >= p->nb_entries ||
+            p->entries[next].offset - p->entries[cur].offset >= p->window) {
+            pthread_cond_wait(&p->cond, &p->lock);
+            continue;
+        }
+
+        for (end = next + 1; end < p->nb_entries; end++)
+            if (p->entries[end].offset - p->entries[next].offset >= PREFETCH_BATCH_SIZE)
+                break;
+        pthread_mutex_unlock(&p->lock);
+
+        ret = prefetch_read(p, next, end);
+
+        pthread_mutex_lock(&p->lock);
+        if (ret < 0) {
+            av_log(p->d, AV_LOG_VERBOSE, "Stopped reading ahead: %s\n",
+                   av_err2str(ret));
+            break;
+        }
+        next = end;
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    return NULL;
+}
+
+static void prefetch_update(Prefetcher *p, const AVPacket *pkt, const AVStream *st)
+{
+    int64_t ts = pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+
+    if (ts == AV_NOPTS_VALUE)
+        return;
+
+    pthread_mutex_lock(&p->lock);
+    p->demux_ts = av_rescale_q(ts, st->time_base, AV_TIME_BASE_Q);
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+}
+
+static void prefetch_stop(Prefetcher **pp)
+{
+    Prefetcher *p = *pp;
+
+    if (!p)
+        return;
+
+    pthread_mutex_lock(&p->lock);
+    p->finish = 1;
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+
+    pthread_join(p->thread, NULL);
+
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+
+    avio_closep(&p->pb);
+    av_freep(&p->buf);
+    av_freep(&p->entries);
+    av_freep(pp);
+}
+
+/* Start reading ahead for local files whose demuxer provides an index with
+ * packet sizes. Failing to do so is not an error, there is just no
+ * readahead then. */
+static int prefetch_start(Demuxer *d, Prefetcher **pp)
+{
+    InputFile         *f = &d->f;
+    AVFormatContext *ic = f->ctx;
+    const char   *proto = avio_find_protocol_name(ic->url);
+    Prefetcher       *p;
+    size_t nb_entries = 0;
+    int64_t offset    = 0;
+    int ret;
+
+    if (!ic->pb || (ic->iformat->flags & AVFMT_NOFILE) ||
+        !proto || strcmp(proto, "file"))
+        return 0;
+
+    for (int i = 0; i < f->nb_streams; i++)
+        if (!ds_from_ist(f->streams[i])->discard)
+            nb_entries += avformat_index_get_entries_count(ic->streams[i]);
+    if (!nb_entries)
+        return 0;
+
+    p = av_mallocz(sizeof(*p));
+    if (!p)
+        return AVERROR(ENOMEM);
+
+    p->d          = d;
+    p->demux_ts   = INT64_MIN;
+    p->window_max = d->readahead_size;
+    p->window     = FFMIN(PREFETCH_BATCH_SIZE, p->window_max);
+
+    p->entries = av_malloc_array(nb_entries, sizeof(*p->entries));
+    p->buf     = av_malloc(PREFETCH_BATCH_SIZE);
+    if (!p->entries || !p->buf) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    for (int i = 0; i < f->nb_streams; i++) {
+        AVStream *st = ic->streams[i];
+        int nb_index_entries = avformat_index_get_entries_count(st);
+
+        if (ds_from_ist(f->streams[i])->discard)
+            continue;
+
+        for (int j = 0; j < nb_index_entries; j++) {
+            const AVIndexEntry *ie = avformat_index_get_entry(st, j);
+            PrefetchEntry *e;
+
+            if (ie->size <= 0 || ie->timestamp == AV_NOPTS_VALUE)
+                continue;
+
+            e       = &p->entries[p->nb_entries++];
+            e->ts   = av_rescale_q(ie->timestamp, st->time_base, AV_TIME_BASE_Q);
+            e->pos  = ie->pos;
+            e->size = ie->size;
+        }
+    }
+    if (!p->nb_entries) {
+        ret = 0;
+        goto fail;
+    }
+
+    qsort(p->entries, p->nb_entries, sizeof(*p->entries), prefetch_entry_cmp);
+    for (size_t i = 0; i < p->nb_entries; i++) {
+        p->entries[i].offset = offset;
+        offset              += p->entries[i].size;
+    }
+
+    ret = avio_open2(&p->pb, ic->url, AVIO_FLAG_READ, &int_cb, NULL);
+    if (ret < 0)
+        goto fail;
+
+    ret = pthread_mutex_init(&p->lock, NULL);
+    if (ret) {
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    ret = pthread_cond_init(&p->cond, NULL);
+    if (ret) {
+        pthread_mutex_destroy(&p->lock);
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    ret = pthread_create(&p->thread, NULL, prefetch_thread, p);
+    if (ret) {
+        pthread_cond_destroy(&p->cond);
+        pthread_mutex_destroy(&p->lock);
+        ret = AVERROR(ret);
+        goto fail;
+    }
+
+    av_log(d, AV_LOG_VERBOSE, "Reading up to %"PRId64" bytes ahead, "
+           "following %zu index entries\n", p->window_max, p->nb_entries);
+
+    *pp = p;
+    return 0;
+fail:
+    avio_closep(&p->pb);
+    av_freep(&p->buf);
+    av_freep(&p->entries);
+    av_freep(&p);
+    return ret;
+}
+
 static void thread_set_name(InputFile *f)
 {
     char name[16];
@@ -692,6 +977,8 @@ static void thread_set_name(InputFile *f)
 
 static void demux_thread_uninit(DemuxThreadContext *dt)
 {
+    prefetch_stop(&dt->prefetch);
+
     av_packet_free(&dt->pkt_demux);
     av_packet_free(&dt->pkt_bsf);
 
@@ -730,6 +1017,13 @@ static int input_thread(void *arg)
 
     discard_unused_programs(f);
 
+    if (d->readahead_size > 0) {
+        ret = prefetch_start(d, &dt.prefetch);
+        if (ret < 0)
+            av_log(d, AV_LOG_WARNING, "Could not start reading ahead: %s\n",
+                   av_err2str(ret));
+    }
+
     d->read_started    = 1;
     d->wallclock_start = av_gettime_relative();
 
@@ -778,6 +1072,10 @@ static int input_thread(void *arg)
                              f->ctx->streams[dt.pkt_demux->stream_index]);
         }
 
+        if (dt.prefetch)
+            prefetch_update(dt.prefetch, dt.pkt_demux,
+                            f->ctx->streams[dt.pkt_demux->stream_index]);
+
         /* the following test is needed in case new streams appear
            dynamically in stream : we ignore them */
         ds = dt.pkt_demux->stream_index < f->nb_streams ?
@@ -1477,6 +1775,8 @@ static int ist_add(const OptionsContext *o, Demuxer *d, AVStream *st, AVDictiona
         opt_match_per_stream_int(ist, &o->top_field_first, ic, st, &ist->top_field_first);
 #endif
 
+        opt_match_per_stream_int(ist, &o->dec_instances, ic, st, &ds->dec_opts.instances);
+
         break;
     case AVMEDIA_TYPE_AUDIO: {
         const char *ch_layout_str = NULL;
@@ -1894,6 +2194,8 @@ int ifile_open(const OptionsContext *o, const char *filename, Scheduler *sch)
     d->min_pts         = (Timestamp){ .ts = AV_NOPTS_VALUE, .tb = (AVRational){ 1, 1 } };
     d->max_pts         = (Timestamp){ .ts = AV_NOPTS_VALUE, .tb = (AVRational){ 1, 1 } };
 
+    d->readahead_size = o->readahead_size;
+
     d->readrate = o->readrate ? o->readrate : 0.0;
     if (d->readrate < 0.0f) {
         av_log(d, AV_LOG_ERROR, "Option -readrate is %0.3f; it must be non-negative.\n", d->readrate);
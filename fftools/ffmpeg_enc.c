@@ -20,6 +20,7 @@
 #include <stdint.h>
 
 #include "ffmpeg.h"
+#include "thread_queue.h"
 
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
@@ -31,8 +32,10 @@
 #include "libavutil/intreadwrite.h"
 #include "libavutil/log.h"
 #include "libavutil/mem.h"
+#include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/rational.h"
+#include "libavutil/thread.h"
 #include "libavutil/time.h"
 #include "libavutil/timestamp.h"
 
@@ -62,10 +65,32 @@ static EncoderPriv *ep_from_enc(Encoder *enc)
     return (EncoderPriv*)enc;
 }
 
+// one encoder instance in chunked encoding mode, see OutputStream.enc_chunks
+typedef struct EncChunk {
+    AVCodecContext *enc_ctx;
+
+    // encoder thread -> chunk thread
+    ThreadQueue    *queue_in;
+    // chunk thread -> encoder thread
+    ThreadQueue    *queue_out;
+
+    pthread_t       thread;
+    int             thread_started;
+
+    // written by the chunk thread before it finishes queue_out
+    int             ret;
+} EncChunk;
+
 // data that is local to the decoder thread and not visible outside of it
 typedef struct EncoderThread {
     AVFrame *frame;
     AVPacket  *pkt;
+
+    // chunked encoding, chunk n is encoded by chunks[n % nb_chunks]
+    EncChunk       *chunks;
+    int          nb_chunks;
+    uint64_t        chunk_idx;
+    int             chunk_frames;
 } EncoderThread;
 
 void enc_free(Encoder **penc)
@@ -349,6 +374,12 @@ int enc_open(void *opaque, const AVFrame *frame)
         return ret;
     }
 
+    if (thread_pool) {
+        enc_ctx->thread_pool = av_buffer_ref(thread_pool);
+        if (!enc_ctx->thread_pool)
+            return AVERROR(ENOMEM);
+    }
+
     if ((ret = avcodec_open2(enc_ctx, enc, NULL)) < 0) {
         if (ret != AVERROR_EXPERIMENTAL)
             av_log(e, AV_LOG_ERROR, "Error while opening encoder - maybe "
@@ -616,41 +647,113 @@ static int update_video_stats(OutputStream *ost, const AVPacket *pkt, int write_
     return 0;
 }
 
-static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame,
-                        AVPacket *pkt)
+static int encode_frame_prepare(OutputStream *ost, AVFrame *frame)
 {
     Encoder            *e = ost->enc;
-    EncoderPriv       *ep = ep_from_enc(e);
     AVCodecContext   *enc = e->enc_ctx;
     const char *type_desc = av_get_media_type_string(enc->codec_type);
-    const char    *action = frame ? "encode" : "flush";
+    FrameData *fd = frame_data(frame);
+
+    if (!fd)
+        return AVERROR(ENOMEM);
+
+    fd->wallclock[LATENCY_PROBE_ENC_PRE] = av_gettime_relative();
+
+    if (ost->enc_stats_pre.io)
+        enc_stats_write(ost, &ost->enc_stats_pre, frame, NULL,
+                        e->frames_encoded);
+
+    e->frames_encoded++;
+    e->samples_encoded += frame->nb_samples;
+
+    if (debug_ts) {
+        av_log(e, AV_LOG_INFO, "encoder <- type:%s "
+               "frame_pts:%s frame_pts_time:%s time_base:%d/%d\n",
+               type_desc,
+               av_ts2str(frame->pts), av_ts2timestr(frame->pts, &enc->time_base),
+               enc->time_base.num, enc->time_base.den);
+    }
+
+    if (frame->sample_aspect_ratio.num && !ost->frame_aspect_ratio.num)
+        enc->sample_aspect_ratio = frame->sample_aspect_ratio;
+
+    return 0;
+}
+
+static int encode_packet_output(OutputStream *ost, AVCodecContext *enc,
+                                AVPacket *pkt)
+{
+    Encoder            *e = ost->enc;
+    EncoderPriv       *ep = ep_from_enc(e);
+    const char *type_desc = av_get_media_type_string(enc->codec_type);
+    FrameData *fd;
     int ret;
 
-    if (frame) {
-        FrameData *fd = frame_data(frame);
+    fd = packet_data(pkt);
+    if (!fd)
+        return AVERROR(ENOMEM);
+    fd->wallclock[LATENCY_PROBE_ENC_POST] = av_gettime_relative();
 
-        if (!fd)
+    // attach stream parameters to first packet if requested
+    avcodec_parameters_free(&fd->par_enc);
+    if (ep->attach_par && !ep->packets_encoded) {
+        fd->par_enc = avcodec_parameters_alloc();
+        if (!fd->par_enc)
             return AVERROR(ENOMEM);
 
-        fd->wallclock[LATENCY_PROBE_ENC_PRE] = av_gettime_relative();
+        ret = avcodec_parameters_from_context(fd->par_enc, enc);
+        if (ret < 0)
+            return ret;
+    }
 
-        if (ost->enc_stats_pre.io)
-            enc_stats_write(ost, &ost->enc_stats_pre, frame, NULL,
-                            e->frames_encoded);
+    pkt->flags |= AV_PKT_FLAG_TRUSTED;
 
-        e->frames_encoded++;
-        e->samples_encoded += frame->nb_samples;
-
-        if (debug_ts) {
-            av_log(e, AV_LOG_INFO, "encoder <- type:%s "
-                   "frame_pts:%s frame_pts_time:%s time_base:%d/%d\n",
-                   type_desc,
-                   av_ts2str(frame->pts), av_ts2timestr(frame->pts, &enc->time_base),
-                   enc->time_base.num, enc->time_base.den);
-        }
+    if (enc->codec_type == AVMEDIA_TYPE_VIDEO) {
+        ret = update_video_stats(ost, pkt, !!vstats_filename);
+        if (ret < 0)
+            return ret;
+    }
+
+    if (ost->enc_stats_post.io)
+        enc_stats_write(ost, &ost->enc_stats_post, NULL, pkt,
+                        ep->packets_encoded);
+
+    if (debug_ts) {
+        av_log(e, AV_LOG_INFO, "encoder -> type:%s "
+               "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s "
+               "duration:%s duration_time:%s\n",
+               type_desc,
+               av_ts2str(pkt->pts), av_ts2timestr(pkt->pts, &enc->time_base),
+               av_ts2str(pkt->dts), av_ts2timestr(pkt->dts, &enc->time_base),
+               av_ts2str(pkt->duration), av_ts2timestr(pkt->duration, &enc->time_base));
+    }
+
+    ep->data_size += pkt->size;
 
-        if (frame->sample_aspect_ratio.num && !ost->frame_aspect_ratio.num)
-            enc->sample_aspect_ratio = frame->sample_aspect_ratio;
+    ep->packets_encoded++;
+
+    ret = sch_enc_send(ep->sch, ep->sch_idx, pkt);
+    if (ret < 0) {
+        av_packet_unref(pkt);
+        return ret;
+    }
+
+    return 0;
+}
+
+static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame,
+                        AVPacket *pkt)
+{
+    Encoder            *e = ost->enc;
+    AVCodecContext   *enc = e->enc_ctx;
+    const char *type_desc = av_get_media_type_string(enc->codec_type);
+    const char    *action = frame ? "encode" : "flush";
+    int ret;
+
+    if (frame) {
+        ret = encode_frame_prepare(ost, frame);
+        if (ret < 0)
+            return ret;
     }
 
     update_benchmark(NULL);
@@ -663,8 +766,6 @@ static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame,
     }
 
     while (1) {
-        FrameData *fd;
-
         av_packet_unref(pkt);
 
         ret = avcodec_receive_packet(enc, pkt);
@@ -686,57 +787,271 @@ static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame,
             return ret;
         }
 
-        fd = packet_data(pkt);
-        if (!fd)
-            return AVERROR(ENOMEM);
-        fd->wallclock[LATENCY_PROBE_ENC_POST] = av_gettime_relative();
+        ret = encode_packet_output(ost, enc, pkt);
+        if (ret < 0)
+            return ret;
+    }
 
-        // attach stream parameters to first packet if requested
-        avcodec_parameters_free(&fd->par_enc);
-        if (ep->attach_par && !ep->packets_encoded) {
-            fd->par_enc = avcodec_parameters_alloc();
-            if (!fd->par_enc)
-                return AVERROR(ENOMEM);
+    av_assert0(0);
+}
 
-            ret = avcodec_parameters_from_context(fd->par_enc, enc);
-            if (ret < 0)
-                return ret;
-        }
+static void *chunk_thread(void *arg)
+{
+    EncChunk *c = arg;
+    AVFrame *frame = av_frame_alloc();
+    AVPacket *pkt  = av_packet_alloc();
+    int ret = 0;
 
-        pkt->flags |= AV_PKT_FLAG_TRUSTED;
+    if (!frame || !pkt) {
+        ret = AVERROR(ENOMEM);
+        goto finish;
+    }
 
-        if (enc->codec_type == AVMEDIA_TYPE_VIDEO) {
-            ret = update_video_stats(ost, pkt, !!vstats_filename);
-            if (ret < 0)
-                return ret;
-        }
+    while (ret >= 0) {
+        int stream_idx;
 
-        if (ost->enc_stats_post.io)
-            enc_stats_write(ost, &ost->enc_stats_post, NULL, pkt,
-                            ep->packets_encoded);
-
-        if (debug_ts) {
-            av_log(e, AV_LOG_INFO, "encoder -> type:%s "
-                   "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s "
-                   "duration:%s duration_time:%s\n",
-                   type_desc,
-                   av_ts2str(pkt->pts), av_ts2timestr(pkt->pts, &enc->time_base),
-                   av_ts2str(pkt->dts), av_ts2timestr(pkt->dts, &enc->time_base),
-                   av_ts2str(pkt->duration), av_ts2timestr(pkt->duration, &enc->time_base));
+        ret = tq_receive(c->queue_in, &stream_idx, frame);
+        ret = avcodec_send_frame(c->enc_ctx, ret >= 0 ? frame : NULL);
+        av_frame_unref(frame);
+        if (ret < 0)
+            break;
+
+        while ((ret = avcodec_receive_packet(c->enc_ctx, pkt)) >= 0) {
+            pkt->time_base = c->enc_ctx->time_base;
+            ret = tq_send(c->queue_out, 0, pkt);
+            if (ret < 0) {
+                av_packet_unref(pkt);
+                goto finish;
+            }
         }
+        if (ret == AVERROR(EAGAIN))
+            ret = 0;
+    }
 
-        ep->data_size += pkt->size;
+finish:
+    c->ret = ret == AVERROR_EOF ? 0 : ret;
+    tq_receive_finish(c->queue_in, 0);
+    tq_send_finish(c->queue_out, 0);
 
-        ep->packets_encoded++;
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
 
-        ret = sch_enc_send(ep->sch, ep->sch_idx, pkt);
-        if (ret < 0) {
-            av_packet_unref(pkt);
+    return NULL;
+}
+
+static int matrix_copy(uint16_t **dst, const uint16_t *src)
+{
+    if (!src)
+        return 0;
+
+    *dst = av_memdup(src, 64 * sizeof(*src));
+    return *dst ? 0 : AVERROR(ENOMEM);
+}
+
+/* Allocate and open an encoder instance for the chunk starting at frame
+ * first_frame, with the same configuration as the template instance
+ * opened by enc_open(), which is never encoded with in chunked mode. */
+static int chunk_ctx_alloc(Encoder *e, AVCodecContext **pctx, int64_t first_frame)
+{
+    const AVCodecContext *tmpl = e->enc_ctx;
+    AVCodecContext *enc_ctx;
+    int ret;
+
+    *pctx = enc_ctx = avcodec_alloc_context3(tmpl->codec);
+    if (!enc_ctx)
+        return AVERROR(ENOMEM);
+
+    ret = av_opt_copy(enc_ctx, tmpl);
+    if (ret < 0)
+        return ret;
+    if (tmpl->codec->priv_class) {
+        ret = av_opt_copy(enc_ctx->priv_data, tmpl->priv_data);
+        if (ret < 0)
+            return ret;
+    }
+
+    // the parameters set by enc_open() which are not AVOptions
+    enc_ctx->time_base              = tmpl->time_base;
+    enc_ctx->framerate              = tmpl->framerate;
+    enc_ctx->width                  = tmpl->width;
+    enc_ctx->height                 = tmpl->height;
+    enc_ctx->sample_aspect_ratio    = tmpl->sample_aspect_ratio;
+    enc_ctx->pix_fmt                = tmpl->pix_fmt;
+    enc_ctx->bits_per_raw_sample    = tmpl->bits_per_raw_sample;
+    enc_ctx->color_range            = tmpl->color_range;
+    enc_ctx->color_primaries        = tmpl->color_primaries;
+    enc_ctx->color_trc              = tmpl->color_trc;
+    enc_ctx->colorspace             = tmpl->colorspace;
+    enc_ctx->chroma_sample_location = tmpl->chroma_sample_location;
+    enc_ctx->field_order            = tmpl->field_order;
+
+    ret = matrix_copy(&enc_ctx->intra_matrix, tmpl->intra_matrix);
+    if (ret < 0)
+        return ret;
+    ret = matrix_copy(&enc_ctx->inter_matrix, tmpl->inter_matrix);
+    if (ret < 0)
+        return ret;
+    ret = matrix_copy(&enc_ctx->chroma_intra_matrix, tmpl->chroma_intra_matrix);
+    if (ret < 0)
+        return ret;
+
+    // the encoder counts frames from the start of the chunk
+    enc_ctx->rc_override_count = 0;
+    if (tmpl->rc_override_count) {
+        enc_ctx->rc_override = av_calloc(tmpl->rc_override_count,
+                                         sizeof(*enc_ctx->rc_override));
+        if (!enc_ctx->rc_override)
+            return AVERROR(ENOMEM);
+    }
+    for (int i = 0; i < tmpl->rc_override_count; i++) {
+        RcOverride rco = tmpl->rc_override[i];
+
+        if (rco.end_frame < first_frame)
+            continue;
+
+        rco.start_frame = FFMAX(rco.start_frame - first_frame, 0);
+        rco.end_frame  -= first_frame;
+        enc_ctx->rc_override[enc_ctx->rc_override_count++] = rco;
+    }
+
+    for (int i = 0; i < tmpl->nb_decoded_side_data; i++) {
+        ret = av_frame_side_data_clone(&enc_ctx->decoded_side_data,
+                                       &enc_ctx->nb_decoded_side_data,
+                                       tmpl->decoded_side_data[i], 0);
+        if (ret < 0)
             return ret;
+    }
+
+    if (tmpl->hw_device_ctx &&
+        !(enc_ctx->hw_device_ctx = av_buffer_ref(tmpl->hw_device_ctx)))
+        return AVERROR(ENOMEM);
+    if (tmpl->hw_frames_ctx &&
+        !(enc_ctx->hw_frames_ctx = av_buffer_ref(tmpl->hw_frames_ctx)))
+        return AVERROR(ENOMEM);
+    if (tmpl->thread_pool &&
+        !(enc_ctx->thread_pool = av_buffer_ref(tmpl->thread_pool)))
+        return AVERROR(ENOMEM);
+
+    ret = avcodec_open2(enc_ctx, enc_ctx->codec, NULL);
+    if (ret < 0)
+        av_log(e, AV_LOG_ERROR, "Error opening encoder for a new chunk: %s\n",
+               av_err2str(ret));
+    return ret;
+}
+
+/* Wait for the chunk encoded by c to finish, passing all its packets on
+ * in order, and release its encoder instance. */
+static int chunk_finish(OutputStream *ost, EncChunk *c, AVPacket *pkt)
+{
+    Encoder *e = ost->enc;
+    int stream_idx, ret = 0, ret_thread;
+
+    if (!c->thread_started)
+        return 0;
+
+    tq_send_finish(c->queue_in, 0);
+
+    while (ret >= 0 && tq_receive(c->queue_out, &stream_idx, pkt) >= 0)
+        ret = encode_packet_output(ost, c->enc_ctx, pkt);
+    av_packet_unref(pkt);
+
+    tq_receive_finish(c->queue_out, 0);
+    pthread_join(c->thread, NULL);
+    c->thread_started = 0;
+    ret_thread = c->ret;
+
+    tq_free(&c->queue_in);
+    tq_free(&c->queue_out);
+    avcodec_free_context(&c->enc_ctx);
+
+    if (ret_thread < 0) {
+        av_log(e, AV_LOG_ERROR, "Error encoding a chunk: %s\n",
+               av_err2str(ret_thread));
+        return ret_thread;
+    }
+    return ret;
+}
+
+static int chunk_start(OutputStream *ost, EncoderThread *et, AVPacket *pkt)
+{
+    Encoder *e = ost->enc;
+    EncChunk *c = &et->chunks[et->chunk_idx % et->nb_chunks];
+    int ret;
+
+    // the instance is reused once the chunk it encoded last is passed on
+    ret = chunk_finish(ost, c, pkt);
+    if (ret < 0)
+        return ret;
+
+    ret = chunk_ctx_alloc(e, &c->enc_ctx, et->chunk_idx * ost->enc_chunk_frames);
+    if (ret < 0)
+        goto fail;
+
+    c->queue_in  = tq_alloc(1, 8, THREAD_QUEUE_FRAMES);
+    // large enough for the chunk thread never to block on it
+    c->queue_out = tq_alloc(1, 2 * ost->enc_chunk_frames + 64, THREAD_QUEUE_PACKETS);
+    if (!c->queue_in || !c->queue_out) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    ret = pthread_create(&c->thread, NULL, chunk_thread, c);
+    if (ret) {
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    c->thread_started = 1;
+
+    et->chunk_idx++;
+    et->chunk_frames = 0;
+
+    return 0;
+fail:
+    tq_free(&c->queue_in);
+    tq_free(&c->queue_out);
+    avcodec_free_context(&c->enc_ctx);
+    return ret;
+}
+
+static int encode_frame_chunked(OutputStream *ost, EncoderThread *et,
+                                AVFrame *frame, AVPacket *pkt)
+{
+    EncChunk *c;
+    int ret;
+
+    if (!frame) {
+        // pass on the remaining chunks, oldest first
+        for (int i = 0; i < et->nb_chunks; i++) {
+            ret = chunk_finish(ost, &et->chunks[(et->chunk_idx + i) % et->nb_chunks], pkt);
+            if (ret < 0)
+                return ret;
         }
+        return AVERROR_EOF;
     }
 
-    av_assert0(0);
+    // this updates the template instance, so it must happen before its
+    // configuration is copied into a new chunk
+    ret = encode_frame_prepare(ost, frame);
+    if (ret < 0)
+        return ret;
+
+    if (!et->chunk_idx || et->chunk_frames == ost->enc_chunk_frames) {
+        ret = chunk_start(ost, et, pkt);
+        if (ret < 0)
+            return ret;
+    }
+    c = &et->chunks[(et->chunk_idx - 1) % et->nb_chunks];
+
+    ret = tq_send(c->queue_in, 0, frame);
+    if (ret == AVERROR_EOF) {
+        // the chunk thread only stops receiving frames on failure
+        ret = chunk_finish(ost, c, pkt);
+        return ret < 0 ? ret : AVERROR_BUG;
+    } else if (ret < 0)
+        return ret;
+    et->chunk_frames++;
+
+    return 0;
 }
 
 static enum AVPictureType forced_kf_apply(void *logctx, KeyframeForceCtx *kf,
@@ -785,7 +1100,8 @@ force_keyframe:
     return AV_PICTURE_TYPE_I;
 }
 
-static int frame_encode(OutputStream *ost, AVFrame *frame, AVPacket *pkt)
+static int frame_encode(OutputStream *ost, EncoderThread *et,
+                        AVFrame *frame, AVPacket *pkt)
 {
     Encoder *e = ost->enc;
     OutputFile *of = ost->file;
@@ -824,7 +1140,8 @@ static int frame_encode(OutputStream *ost, AVFrame *frame, AVPacket *pkt)
         }
     }
 
-    return encode_frame(of, ost, frame, pkt);
+    return et->nb_chunks ? encode_frame_chunked(ost, et, frame, pkt) :
+                           encode_frame(of, ost, frame, pkt);
 }
 
 static void enc_thread_set_name(const OutputStream *ost)
@@ -837,16 +1154,37 @@ static void enc_thread_set_name(const OutputStream *ost)
 
 static void enc_thread_uninit(EncoderThread *et)
 {
+    for (int i = 0; i < et->nb_chunks; i++) {
+        EncChunk *c = &et->chunks[i];
+
+        if (c->thread_started) {
+            tq_send_finish(c->queue_in, 0);
+            tq_receive_finish(c->queue_out, 0);
+            pthread_join(c->thread, NULL);
+        }
+        tq_free(&c->queue_in);
+        tq_free(&c->queue_out);
+        avcodec_free_context(&c->enc_ctx);
+    }
+    av_freep(&et->chunks);
+
     av_packet_free(&et->pkt);
     av_frame_free(&et->frame);
 
     memset(et, 0, sizeof(*et));
 }
 
-static int enc_thread_init(EncoderThread *et)
+static int enc_thread_init(EncoderThread *et, const OutputStream *ost)
 {
     memset(et, 0, sizeof(*et));
 
+    if (ost->type == AVMEDIA_TYPE_VIDEO && ost->enc_chunks > 1) {
+        et->chunks = av_calloc(ost->enc_chunks, sizeof(*et->chunks));
+        if (!et->chunks)
+            goto fail;
+        et->nb_chunks = ost->enc_chunks;
+    }
+
     et->frame = av_frame_alloc();
     if (!et->frame)
         goto fail;
@@ -871,7 +1209,7 @@ int encoder_thread(void *arg)
     int ret = 0, input_status = 0;
     int name_set = 0;
 
-    ret = enc_thread_init(&et);
+    ret = enc_thread_init(&et, ost);
     if (ret < 0)
         goto finish;
 
@@ -911,7 +1249,7 @@ int encoder_thread(void *arg)
             name_set = 1;
         }
 
-        ret = frame_encode(ost, et.frame, et.pkt);
+        ret = frame_encode(ost, &et, et.frame, et.pkt);
 
         av_packet_unref(et.pkt);
         av_frame_unref(et.frame);
@@ -928,7 +1266,7 @@ int encoder_thread(void *arg)
 
     // flush the encoder
     if (ret == 0 || ret == AVERROR_EOF) {
-        ret = frame_encode(ost, NULL, et.pkt);
+        ret = frame_encode(ost, &et, NULL, et.pkt);
         if (ret < 0 && ret != AVERROR_EOF)
             av_log(e, AV_LOG_ERROR, "Error flushing encoder: %s\n",
                    av_err2str(ret));
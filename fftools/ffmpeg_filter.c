@@ -1916,6 +1916,12 @@ static int configure_filtergraph(FilterGraph *fg, FilterGraphThread *fgt)
     if (!fgt->graph)
         return AVERROR(ENOMEM);
 
+    if (thread_pool) {
+        fgt->graph->thread_pool = av_buffer_ref(thread_pool);
+        if (!fgt->graph->thread_pool)
+            return AVERROR(ENOMEM);
+    }
+
     if (simple) {
         OutputFilterPriv *ofp = ofp_from_ofilter(fg->outputs[0]);
 
@@ -135,6 +135,37 @@ static void mux_log_debug_ts(OutputStream *ost, const AVPacket *pkt)
            pkt->size, *latency ? latency : "N/A");
 }
 
+static void mux_latency_update(OutputStream *ost, const AVPacket *pkt)
+{
+    const FrameData *fd;
+    int64_t now, first = INT64_MIN;
+
+    if (!pkt->opaque_ref)
+        return;
+
+    fd  = (FrameData*)pkt->opaque_ref->data;
+    now = av_gettime_relative();
+
+    for (int i = LATENCY_PROBE_NB - 1, next = LATENCY_PROBE_NB; i >= 0; i--) {
+        int64_t val = fd->wallclock[i];
+
+        if (val == INT64_MIN)
+            continue;
+
+        atomic_fetch_add_explicit(&ost->latency_stage[i],
+                                  (next == LATENCY_PROBE_NB ? now : fd->wallclock[next]) - val,
+                                  memory_order_relaxed);
+        first = val;
+        next  = i;
+    }
+
+    if (first == INT64_MIN)
+        return;
+
+    atomic_fetch_add_explicit(&ost->latency_total, now - first, memory_order_relaxed);
+    atomic_fetch_add_explicit(&ost->latency_count, 1, memory_order_relaxed);
+}
+
 static int mux_fixup_ts(Muxer *mux, MuxStream *ms, AVPacket *pkt)
 {
     OutputStream *ost = &ms->ost;
@@ -202,6 +233,8 @@ static int mux_fixup_ts(Muxer *mux, MuxStream *ms, AVPacket *pkt)
 
     if (debug_ts)
         mux_log_debug_ts(ost, pkt);
+    if (sched_stats)
+        mux_latency_update(ost, pkt);
 
     return 0;
 }
@@ -754,6 +754,20 @@ static int new_stream_video(Muxer *mux, const OptionsContext *o,
             }
         }
 
+        ost->enc_chunk_frames = 250;
+        opt_match_per_stream_int(ost, &o->enc_chunks, oc, st, &ost->enc_chunks);
+        opt_match_per_stream_int(ost, &o->enc_chunk_frames, oc, st, &ost->enc_chunk_frames);
+        if (ost->enc_chunks == 1)
+            ost->enc_chunks = 0;
+        if (ost->enc_chunks < 0 || ost->enc_chunk_frames <= 0) {
+            av_log(ost, AV_LOG_ERROR, "Invalid chunked encoding parameters\n");
+            return AVERROR(EINVAL);
+        }
+        if (ost->enc_chunks && do_pass) {
+            av_log(ost, AV_LOG_ERROR, "Chunked encoding is not supported with two-pass encoding\n");
+            return AVERROR(EINVAL);
+        }
+
         opt_match_per_stream_int(ost, &o->force_fps, oc, st, &ms->force_fps);
 
 #if FFMPEG_OPT_TOP
@@ -47,6 +47,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/parseutils.h"
 #include "libavutil/stereo3d.h"
+#include "libavutil/threadpool.h"
 #include "graph/graphprint.h"
 
 HWDevice *filter_hw_device;
@@ -79,9 +80,12 @@ int filter_buffered_frames = 0;
 int vstats_version = 2;
 int print_graphs = 0;
 char *print_graphs_file = NULL;
+char *trace_events_file = NULL;
+AVBufferRef *thread_pool;
 char *print_graphs_format = NULL;
 int auto_conversion_filters = 1;
 int64_t stats_period = 500000;
+int sched_stats = 0;
 
 
 static int file_overwrite     = 0;
@@ -960,6 +964,25 @@ static int opt_vstats_file(void *optctx, const char *opt, const char *arg)
     return 0;
 }
 
+static int opt_thread_pool(void *optctx, const char *opt, const char *arg)
+{
+    double num;
+    int ret;
+
+    ret = parse_number(opt, arg, OPT_TYPE_INT, 0, INT_MAX, &num);
+    if (ret < 0)
+        return ret;
+
+    av_buffer_unref(&thread_pool);
+    ret = av_thread_pool_create(&thread_pool, num);
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Error creating thread pool: %s\n",
+               av_err2str(ret));
+        return ret;
+    }
+    return 0;
+}
+
 static int opt_vstats(void *optctx, const char *opt, const char *arg)
 {
     char filename[40];
@@ -1647,6 +1670,9 @@ const OptionDef options[] = {
     { "readrate_catchup",       OPT_TYPE_FLOAT, OPT_OFFSET | OPT_EXPERT | OPT_INPUT,
         { .off = OFFSET(readrate_catchup) },
         "Temporary readrate used to catch up if an input lags behind the specified readrate", "speed" },
+    { "readahead_size",         OPT_TYPE_INT64, OPT_OFFSET | OPT_EXPERT | OPT_INPUT,
+        { .off = OFFSET(readahead_size) },
+        "read up to this many bytes of upcoming packets ahead of the demuxer, following the index", "size" },
     { "target",                 OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_PERFILE | OPT_EXPERT | OPT_OUTPUT,
         { .func_arg = opt_target },
         "specify target file type (\"vcd\", \"svcd\", \"dvd\", \"dv\" or \"dv50\" "
@@ -1762,6 +1788,9 @@ const OptionDef options[] = {
     { "stats_period",        OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_EXPERT,
         { .func_arg = opt_stats_period },
         "set the period at which ffmpeg updates stats and -progress output", "time" },
+    { "sched_stats",         OPT_TYPE_BOOL, OPT_EXPERT,
+        { &sched_stats },
+        "add per-node scheduler statistics to the -progress output" },
     { "attach",              OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_PERFILE | OPT_EXPERT | OPT_OUTPUT,
         { .func_arg = opt_attach },
         "add an attachment to the output file", "filename" },
@@ -1773,6 +1802,12 @@ const OptionDef options[] = {
     { "debug_ts",            OPT_TYPE_BOOL, OPT_EXPERT,
         { &debug_ts },
         "print timestamp debugging info" },
+    { "thread_pool",         OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_EXPERT,
+        { .func_arg = opt_thread_pool },
+        "run slice threading of all decoders, encoders and filtergraphs on one shared pool of threads", "number" },
+    { "trace_events",        OPT_TYPE_STRING, OPT_EXPERT,
+        { &trace_events_file },
+        "write internal processing trace events to the specified file", "filename" },
     { "max_error_rate",      OPT_TYPE_FLOAT, OPT_EXPERT,
         { &max_error_rate },
         "ratio of decoding errors (0.0: no errors, 1.0: 100% errors) above which ffmpeg returns an error instead of success.", "maximum error rate" },
@@ -1862,6 +1897,12 @@ const OptionDef options[] = {
     { "passlogfile",                OPT_TYPE_STRING, OPT_VIDEO | OPT_EXPERT | OPT_PERSTREAM | OPT_OUTPUT,
         { .off = OFFSET(passlogfiles) },
         "select two pass log file name prefix", "prefix" },
+    { "enc_chunks",                 OPT_TYPE_INT,    OPT_VIDEO | OPT_EXPERT | OPT_PERSTREAM | OPT_OUTPUT,
+        { .off = OFFSET(enc_chunks) },
+        "encode chunks of the stream with several encoder instances in parallel", "number" },
+    { "enc_chunk_frames",           OPT_TYPE_INT,    OPT_VIDEO | OPT_EXPERT | OPT_PERSTREAM | OPT_OUTPUT,
+        { .off = OFFSET(enc_chunk_frames) },
+        "set the number of frames per chunk for chunked encoding", "frames" },
     { "vstats",                     OPT_TYPE_FUNC,   OPT_VIDEO | OPT_EXPERT,
         { .func_arg = opt_vstats },
         "dump video coding statistics to file" },
@@ -1924,6 +1965,9 @@ const OptionDef options[] = {
     { "apply_cropping",             OPT_TYPE_STRING, OPT_VIDEO | OPT_PERSTREAM | OPT_EXPERT | OPT_INPUT,
         { .off = OFFSET(apply_cropping) },
         "select the cropping to apply" },
+    { "dec_instances",              OPT_TYPE_INT,    OPT_VIDEO | OPT_PERSTREAM | OPT_EXPERT | OPT_INPUT,
+        { .off = OFFSET(dec_instances) },
+        "decode intra-only video with this many decoder instances in parallel", "number" },
     { "fix_sub_duration_heartbeat", OPT_TYPE_BOOL,   OPT_VIDEO | OPT_EXPERT | OPT_PERSTREAM | OPT_OUTPUT,
         { .off = OFFSET(fix_sub_duration_heartbeat) },
         "set this video output stream to be a heartbeat stream for "
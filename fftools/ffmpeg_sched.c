@@ -32,6 +32,7 @@
 #include "libavcodec/packet.h"
 
 #include "libavutil/avassert.h"
+#include "libavutil/bprint.h"
 #include "libavutil/error.h"
 #include "libavutil/fifo.h"
 #include "libavutil/frame.h"
@@ -54,6 +55,9 @@ typedef struct SchWaiter {
     pthread_cond_t      cond;
     atomic_int          choked;
 
+    // total time in microseconds spent waiting while choked
+    atomic_int_least64_t choked_time;
+
     // the following are internal state of schedule_update_locked() and must not
     // be accessed outside of it
     int                 choked_prev;
@@ -69,6 +73,12 @@ typedef struct SchTask {
 
     pthread_t           thread;
     int                 thread_running;
+
+    // wallclock times at which the thread started and finished, and the
+    // total time it spent blocked in scheduler calls, in microseconds
+    atomic_int_least64_t time_start;
+    atomic_int_least64_t time_end;
+    atomic_int_least64_t time_blocked;
 } SchTask;
 
 typedef struct SchDecOutput {
@@ -321,11 +331,14 @@ struct Scheduler {
  */
 static int waiter_wait(Scheduler *sch, SchWaiter *w)
 {
+    int64_t wait_start;
     int terminate;
 
     if (!atomic_load(&w->choked))
         return 0;
 
+    wait_start = av_gettime_relative();
+
     pthread_mutex_lock(&w->lock);
 
     while (atomic_load(&w->choked) && !atomic_load(&sch->terminate))
@@ -335,6 +348,8 @@ static int waiter_wait(Scheduler *sch, SchWaiter *w)
 
     pthread_mutex_unlock(&w->lock);
 
+    atomic_fetch_add(&w->choked_time, av_gettime_relative() - wait_start);
+
     return terminate;
 }
 
@@ -353,6 +368,7 @@ static int waiter_init(SchWaiter *w)
     int ret;
 
     atomic_init(&w->choked, 0);
+    atomic_init(&w->choked_time, 0);
 
     ret = pthread_mutex_init(&w->lock, NULL);
     if (ret)
@@ -432,6 +448,29 @@ static void task_init(Scheduler *sch, SchTask *task, enum SchedulerNodeType type
 
     task->func      = func;
     task->func_arg  = func_arg;
+
+    atomic_init(&task->time_start,   INT64_MIN);
+    atomic_init(&task->time_end,     INT64_MIN);
+    atomic_init(&task->time_blocked, 0);
+}
+
+static void task_blocked_add(SchTask *task, int64_t start)
+{
+    atomic_fetch_add_explicit(&task->time_blocked, av_gettime_relative() - start,
+                              memory_order_relaxed);
+}
+
+// time the task spent doing actual work, i.e. not waiting in the scheduler
+static int64_t task_busy_time(SchTask *task, int64_t now)
+{
+    int64_t start = atomic_load(&task->time_start);
+    int64_t end   = atomic_load(&task->time_end);
+
+    if (start == INT64_MIN)
+        return 0;
+
+    return FFMAX((end == INT64_MIN ? now : end) - start -
+                 atomic_load(&task->time_blocked), 0);
 }
 
 static int64_t trailing_dts(const Scheduler *sch, int count_finished)
@@ -1679,6 +1718,67 @@ int sch_wait(Scheduler *sch, uint64_t timeout_us, int64_t *transcode_ts)
     return ret;
 }
 
+static void print_queue_stats(AVBPrint *bp, const char *type, unsigned idx,
+                              ThreadQueue *tq)
+{
+    ThreadQueueStats st;
+
+    if (!tq)
+        return;
+
+    tq_stats(tq, &st);
+
+    av_bprintf(bp, "sched_%s_%u_queued=%zu\n",     type, idx, st.queued);
+    av_bprintf(bp, "sched_%s_%u_queue_size=%zu\n", type, idx, st.queue_size);
+    av_bprintf(bp, "sched_%s_%u_items=%"PRIu64"\n", type, idx, st.nb_items);
+    av_bprintf(bp, "sched_%s_%u_input_wait_us=%"PRId64"\n",
+               type, idx, st.recv_wait);
+    av_bprintf(bp, "sched_%s_%u_backpressure_us=%"PRId64"\n",
+               type, idx, st.send_wait);
+}
+
+void sch_print_stats(Scheduler *sch, AVBPrint *bp)
+{
+    int64_t now = av_gettime_relative();
+
+    for (unsigned i = 0; i < sch->nb_demux; i++) {
+        SchDemux *d = &sch->demux[i];
+
+        av_bprintf(bp, "sched_demux_%u_busy_us=%"PRId64"\n", i,
+                   task_busy_time(&d->task, now));
+        av_bprintf(bp, "sched_demux_%u_choked_us=%"PRId64"\n", i,
+                   (int64_t)atomic_load(&d->waiter.choked_time));
+    }
+
+    for (unsigned i = 0; i < sch->nb_dec; i++) {
+        av_bprintf(bp, "sched_dec_%u_busy_us=%"PRId64"\n", i,
+                   task_busy_time(&sch->dec[i].task, now));
+        print_queue_stats(bp, "dec", i, sch->dec[i].queue);
+    }
+
+    for (unsigned i = 0; i < sch->nb_filters; i++) {
+        SchFilterGraph *fg = &sch->filters[i];
+
+        av_bprintf(bp, "sched_filter_%u_busy_us=%"PRId64"\n", i,
+                   task_busy_time(&fg->task, now));
+        print_queue_stats(bp, "filter", i, fg->queue);
+        av_bprintf(bp, "sched_filter_%u_choked_us=%"PRId64"\n", i,
+                   (int64_t)atomic_load(&fg->waiter.choked_time));
+    }
+
+    for (unsigned i = 0; i < sch->nb_enc; i++) {
+        av_bprintf(bp, "sched_enc_%u_busy_us=%"PRId64"\n", i,
+                   task_busy_time(&sch->enc[i].task, now));
+        print_queue_stats(bp, "enc", i, sch->enc[i].queue);
+    }
+
+    for (unsigned i = 0; i < sch->nb_mux; i++) {
+        av_bprintf(bp, "sched_mux_%u_busy_us=%"PRId64"\n", i,
+                   task_busy_time(&sch->mux[i].task, now));
+        print_queue_stats(bp, "mux", i, sch->mux[i].queue);
+    }
+}
+
 static int enc_open(Scheduler *sch, SchEnc *enc, const AVFrame *frame)
 {
     int ret;
@@ -2026,8 +2126,8 @@ static int demux_flush(Scheduler *sch, SchDemux *d, AVPacket *pkt)
     return 0;
 }
 
-int sch_demux_send(Scheduler *sch, unsigned demux_idx, AVPacket *pkt,
-                   unsigned flags)
+static int demux_send_timed(Scheduler *sch, unsigned demux_idx, AVPacket *pkt,
+                            unsigned flags)
 {
     SchDemux *d;
     int terminate;
@@ -2048,6 +2148,15 @@ int sch_demux_send(Scheduler *sch, unsigned demux_idx, AVPacket *pkt,
     return demux_send_for_stream(sch, d, &d->streams[pkt->stream_index], pkt, flags);
 }
 
+int sch_demux_send(Scheduler *sch, unsigned demux_idx, AVPacket *pkt,
+                   unsigned flags)
+{
+    int64_t start = av_gettime_relative();
+    int ret = demux_send_timed(sch, demux_idx, pkt, flags);
+    task_blocked_add(&sch->demux[demux_idx].task, start);
+    return ret;
+}
+
 static int demux_done(Scheduler *sch, unsigned demux_idx)
 {
     SchDemux *d = &sch->demux[demux_idx];
@@ -2070,7 +2179,7 @@ static int demux_done(Scheduler *sch, unsigned demux_idx)
     return ret;
 }
 
-int sch_mux_receive(Scheduler *sch, unsigned mux_idx, AVPacket *pkt)
+static int mux_receive_timed(Scheduler *sch, unsigned mux_idx, AVPacket *pkt)
 {
     SchMux *mux;
     int ret, stream_idx;
@@ -2083,6 +2192,14 @@ int sch_mux_receive(Scheduler *sch, unsigned mux_idx, AVPacket *pkt)
     return ret;
 }
 
+int sch_mux_receive(Scheduler *sch, unsigned mux_idx, AVPacket *pkt)
+{
+    int64_t start = av_gettime_relative();
+    int ret = mux_receive_timed(sch, mux_idx, pkt);
+    task_blocked_add(&sch->mux[mux_idx].task, start);
+    return ret;
+}
+
 void sch_mux_receive_finish(Scheduler *sch, unsigned mux_idx, unsigned stream_idx)
 {
     SchMux *mux;
@@ -2154,7 +2271,7 @@ static int mux_done(Scheduler *sch, unsigned mux_idx)
     return 0;
 }
 
-int sch_dec_receive(Scheduler *sch, unsigned dec_idx, AVPacket *pkt)
+static int dec_receive_timed(Scheduler *sch, unsigned dec_idx, AVPacket *pkt)
 {
     SchDec *dec;
     int ret, dummy;
@@ -2183,6 +2300,14 @@ int sch_dec_receive(Scheduler *sch, unsigned dec_idx, AVPacket *pkt)
     return ret;
 }
 
+int sch_dec_receive(Scheduler *sch, unsigned dec_idx, AVPacket *pkt)
+{
+    int64_t start = av_gettime_relative();
+    int ret = dec_receive_timed(sch, dec_idx, pkt);
+    task_blocked_add(&sch->dec[dec_idx].task, start);
+    return ret;
+}
+
 static int send_to_filter(Scheduler *sch, SchFilterGraph *fg,
                           unsigned in_idx, AVFrame *frame)
 {
@@ -2230,8 +2355,8 @@ finish:
     return AVERROR_EOF;
 }
 
-int sch_dec_send(Scheduler *sch, unsigned dec_idx,
-                 unsigned out_idx, AVFrame *frame)
+static int dec_send_timed(Scheduler *sch, unsigned dec_idx,
+                          unsigned out_idx, AVFrame *frame)
 {
     SchDec *dec;
     SchDecOutput *o;
@@ -2274,6 +2399,15 @@ int sch_dec_send(Scheduler *sch, unsigned dec_idx,
     return (nb_done == o->nb_dst) ? AVERROR_EOF : 0;
 }
 
+int sch_dec_send(Scheduler *sch, unsigned dec_idx,
+                 unsigned out_idx, AVFrame *frame)
+{
+    int64_t start = av_gettime_relative();
+    int ret = dec_send_timed(sch, dec_idx, out_idx, frame);
+    task_blocked_add(&sch->dec[dec_idx].task, start);
+    return ret;
+}
+
 static int dec_done(Scheduler *sch, unsigned dec_idx)
 {
     SchDec *dec = &sch->dec[dec_idx];
@@ -2299,7 +2433,7 @@ static int dec_done(Scheduler *sch, unsigned dec_idx)
     return ret;
 }
 
-int sch_enc_receive(Scheduler *sch, unsigned enc_idx, AVFrame *frame)
+static int enc_receive_timed(Scheduler *sch, unsigned enc_idx, AVFrame *frame)
 {
     SchEnc *enc;
     int ret, dummy;
@@ -2313,6 +2447,14 @@ int sch_enc_receive(Scheduler *sch, unsigned enc_idx, AVFrame *frame)
     return ret;
 }
 
+int sch_enc_receive(Scheduler *sch, unsigned enc_idx, AVFrame *frame)
+{
+    int64_t start = av_gettime_relative();
+    int ret = enc_receive_timed(sch, enc_idx, frame);
+    task_blocked_add(&sch->enc[enc_idx].task, start);
+    return ret;
+}
+
 static int enc_send_to_dst(Scheduler *sch, const SchedulerNode dst,
                            uint8_t *dst_finished, AVPacket *pkt)
 {
@@ -2343,7 +2485,7 @@ finish:
     return AVERROR_EOF;
 }
 
-int sch_enc_send(Scheduler *sch, unsigned enc_idx, AVPacket *pkt)
+static int enc_send_timed(Scheduler *sch, unsigned enc_idx, AVPacket *pkt)
 {
     SchEnc *enc;
     int ret;
@@ -2376,6 +2518,14 @@ int sch_enc_send(Scheduler *sch, unsigned enc_idx, AVPacket *pkt)
     return 0;
 }
 
+int sch_enc_send(Scheduler *sch, unsigned enc_idx, AVPacket *pkt)
+{
+    int64_t start = av_gettime_relative();
+    int ret = enc_send_timed(sch, enc_idx, pkt);
+    task_blocked_add(&sch->enc[enc_idx].task, start);
+    return ret;
+}
+
 static int enc_done(Scheduler *sch, unsigned enc_idx)
 {
     SchEnc *enc = &sch->enc[enc_idx];
@@ -2392,8 +2542,8 @@ static int enc_done(Scheduler *sch, unsigned enc_idx)
     return ret;
 }
 
-int sch_filter_receive(Scheduler *sch, unsigned fg_idx,
-                       unsigned *in_idx, AVFrame *frame)
+static int filter_receive_timed(Scheduler *sch, unsigned fg_idx,
+                                unsigned *in_idx, AVFrame *frame)
 {
     SchFilterGraph *fg;
 
@@ -2436,6 +2586,15 @@ int sch_filter_receive(Scheduler *sch, unsigned fg_idx,
     }
 }
 
+int sch_filter_receive(Scheduler *sch, unsigned fg_idx,
+                       unsigned *in_idx, AVFrame *frame)
+{
+    int64_t start = av_gettime_relative();
+    int ret = filter_receive_timed(sch, fg_idx, in_idx, frame);
+    task_blocked_add(&sch->filters[fg_idx].task, start);
+    return ret;
+}
+
 void sch_filter_receive_finish(Scheduler *sch, unsigned fg_idx, unsigned in_idx)
 {
     SchFilterGraph *fg;
@@ -2457,7 +2616,7 @@ void sch_filter_receive_finish(Scheduler *sch, unsigned fg_idx, unsigned in_idx)
     }
 }
 
-int sch_filter_send(Scheduler *sch, unsigned fg_idx, unsigned out_idx, AVFrame *frame)
+static int filter_send_timed(Scheduler *sch, unsigned fg_idx, unsigned out_idx, AVFrame *frame)
 {
     SchFilterGraph *fg;
     SchedulerNode  dst;
@@ -2473,6 +2632,14 @@ int sch_filter_send(Scheduler *sch, unsigned fg_idx, unsigned out_idx, AVFrame *
            send_to_filter(sch, &sch->filters[dst.idx], dst.idx_stream, frame);
 }
 
+int sch_filter_send(Scheduler *sch, unsigned fg_idx, unsigned out_idx, AVFrame *frame)
+{
+    int64_t start = av_gettime_relative();
+    int ret = filter_send_timed(sch, fg_idx, out_idx, frame);
+    task_blocked_add(&sch->filters[fg_idx].task, start);
+    return ret;
+}
+
 static int filter_done(Scheduler *sch, unsigned fg_idx)
 {
     SchFilterGraph *fg = &sch->filters[fg_idx];
@@ -2531,6 +2698,8 @@ static void *task_wrapper(void *arg)
     int ret;
     int err = 0;
 
+    atomic_store(&task->time_start, av_gettime_relative());
+
     ret = task->func(task->func_arg);
     if (ret < 0)
         av_log(task->func_arg, AV_LOG_ERROR,
@@ -2539,6 +2708,8 @@ static void *task_wrapper(void *arg)
     err = task_cleanup(sch, task->node);
     ret = err_merge(ret, err);
 
+    atomic_store(&task->time_end, av_gettime_relative());
+
     // EOF is considered normal termination
     if (ret == AVERROR_EOF)
         ret = 0;
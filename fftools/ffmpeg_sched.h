@@ -85,6 +85,7 @@
  * knowledge about the whole transcoding pipeline.
  */
 
+struct AVBPrint;
 struct AVFrame;
 struct AVPacket;
 
@@ -149,6 +150,18 @@ int sch_stop(Scheduler *sch, int64_t *finish_ts);
  */
 int sch_wait(Scheduler *sch, uint64_t timeout_us, int64_t *transcode_ts);
 
+/**
+ * Print per-node scheduler statistics as key=value lines, in the same format
+ * as the -progress output. For each node with an input queue, this includes
+ * the number of queued and total items, the time the node spent waiting for
+ * input and the time its producers spent blocked on the full queue. For
+ * demuxers and filtergraphs, the time spent choked by the scheduler is
+ * printed as well.
+ *
+ * May be called while transcoding is running.
+ */
+void sch_print_stats(Scheduler *sch, struct AVBPrint *bp);
+
 /**
  * Add a demuxer to the scheduler.
  *
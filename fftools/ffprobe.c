@@ -96,6 +96,7 @@ static int do_analyze_frames = 0;
 static int do_bitexact = 0;
 static int do_count_frames = 0;
 static int do_count_packets = 0;
+static int do_index_only = 0;
 static int do_read_frames  = 0;
 static int do_read_packets = 0;
 static int do_show_chapters = 0;
@@ -1656,12 +1657,136 @@ end:
     return ret;
 }
 
+/**
+ * Check whether the demuxer built an index with one entry for every packet
+ * of the stream, which is the case e.g. for non-fragmented MP4.
+ */
+static int index_is_complete(const AVStream *st)
+{
+    return st->nb_frames > 0 &&
+           avformat_index_get_entries_count(st) == st->nb_frames;
+}
+
+/**
+ * Count and/or show the packets of all selected streams that have a complete
+ * index, without reading their payload.
+ *
+ * @param from_index set to 1 for every stream handled here
+ * @return number of selected streams that still need to be demuxed, or a
+ *         negative error code
+ */
+static int read_index_packets(AVTextFormatContext *tfc, InputFile *ifile,
+                              uint8_t *from_index)
+{
+    AVFormatContext *fmt_ctx = ifile->fmt_ctx;
+    AVPacket *pkt = NULL;
+    int *next = NULL;
+    int nb_left = 0, pkt_idx = 0;
+
+    for (int i = 0; i < fmt_ctx->nb_streams; i++) {
+        if (!selected_streams[i])
+            continue;
+        if (index_is_complete(fmt_ctx->streams[i]))
+            from_index[i] = 1;
+        else
+            nb_left++;
+    }
+
+    if (!do_show_packets) {
+        for (int i = 0; i < fmt_ctx->nb_streams; i++)
+            if (from_index[i])
+                nb_streams_packets[i] = avformat_index_get_entries_count(fmt_ctx->streams[i]);
+        return nb_left;
+    }
+
+    pkt  = av_packet_alloc();
+    next = av_calloc(fmt_ctx->nb_streams, sizeof(*next));
+    if (!pkt || !next) {
+        av_packet_free(&pkt);
+        av_freep(&next);
+        return AVERROR(ENOMEM);
+    }
+
+    /* output the entries of all streams in file order, like the demuxer would */
+    while (1) {
+        const AVIndexEntry *e = NULL, *e_next;
+        AVStream *st;
+        int idx = -1;
+
+        for (int i = 0; i < fmt_ctx->nb_streams; i++) {
+            const AVIndexEntry *cand;
+
+            if (!from_index[i])
+                continue;
+            cand = avformat_index_get_entry(fmt_ctx->streams[i], next[i]);
+            if (cand && (!e || cand->pos < e->pos)) {
+                e   = cand;
+                idx = i;
+            }
+        }
+        if (!e)
+            break;
+
+        st     = fmt_ctx->streams[idx];
+        e_next = avformat_index_get_entry(st, ++next[idx]);
+
+        /* the index only stores decoding timestamps, so presentation
+         * timestamps are only known for streams without reordering */
+        pkt->stream_index = idx;
+        pkt->dts          = e->timestamp;
+        pkt->pts          = st->codecpar->codec_type != AVMEDIA_TYPE_VIDEO ||
+                            !st->codecpar->video_delay ? e->timestamp : AV_NOPTS_VALUE;
+        if (e_next)
+            pkt->duration = e_next->timestamp - e->timestamp;
+        else if (st->duration > 0)
+            pkt->duration = FFMAX((st->start_time != AV_NOPTS_VALUE ? st->start_time : 0) +
+                                  st->duration - e->timestamp, 0);
+        else
+            pkt->duration = 0;
+        pkt->size         = e->size;
+        pkt->pos          = e->pos;
+        pkt->flags        = (e->flags & AVINDEX_KEYFRAME      ? AV_PKT_FLAG_KEY     : 0) |
+                            (e->flags & AVINDEX_DISCARD_FRAME ? AV_PKT_FLAG_DISCARD : 0);
+
+        show_packet(tfc, ifile, pkt, pkt_idx++);
+        nb_streams_packets[idx]++;
+    }
+
+    av_packet_free(&pkt);
+    av_freep(&next);
+
+    return nb_left;
+}
+
 static int read_packets(AVTextFormatContext *tfc, InputFile *ifile)
 {
     AVFormatContext *fmt_ctx = ifile->fmt_ctx;
+    unsigned nb_index_streams = fmt_ctx->nb_streams;
+    uint8_t *from_index = NULL;
     int i, ret = 0;
     int64_t cur_ts = fmt_ctx->start_time;
 
+    /* the index carries no payload, and frames need to be decoded */
+    if (do_index_only && !do_read_frames && !do_show_data && !show_data_hash &&
+        read_intervals_nb == 0) {
+        from_index = av_calloc(nb_index_streams, sizeof(*from_index));
+        if (!from_index)
+            return AVERROR(ENOMEM);
+
+        ret = read_index_packets(tfc, ifile, from_index);
+        if (ret <= 0)
+            goto end;
+
+        /* demux the remaining streams only */
+        for (i = 0; i < nb_index_streams; i++) {
+            if (from_index[i]) {
+                selected_streams[i] = 0;
+                fmt_ctx->streams[i]->discard = AVDISCARD_ALL;
+            }
+        }
+        ret = 0;
+    }
+
     if (read_intervals_nb == 0) {
         ReadInterval interval = (ReadInterval) { .has_start = 0, .has_end = 0 };
         ret = read_interval_packets(tfc, ifile, &interval, &cur_ts);
@@ -1673,6 +1798,17 @@ static int read_packets(AVTextFormatContext *tfc, InputFile *ifile)
         }
     }
 
+    if (from_index) {
+        for (i = 0; i < nb_index_streams; i++) {
+            if (from_index[i]) {
+                selected_streams[i] = 1;
+                fmt_ctx->streams[i]->discard = AVDISCARD_DEFAULT;
+            }
+        }
+    }
+
+end:
+    av_freep(&from_index);
     return ret;
 }
 
@@ -3116,6 +3252,7 @@ static const OptionDef real_options[] = {
     { "show_chapters",         OPT_TYPE_FUNC,        0, { .func_arg = &opt_show_chapters }, "show chapters info" },
     { "count_frames",          OPT_TYPE_BOOL,        0, { &do_count_frames }, "count the number of frames per stream" },
     { "count_packets",         OPT_TYPE_BOOL,        0, { &do_count_packets }, "count the number of packets per stream" },
+    { "index_only",            OPT_TYPE_BOOL,        0, { &do_index_only }, "read packet information from the container index when it is complete" },
     { "show_program_version",  OPT_TYPE_FUNC,        0, { .func_arg = &opt_show_program_version },  "show ffprobe version" },
     { "show_library_versions", OPT_TYPE_FUNC,        0, { .func_arg = &opt_show_library_versions }, "show library versions" },
     { "show_versions",         OPT_TYPE_FUNC,        0, { .func_arg = &opt_show_versions }, "show program and library versions" },
@@ -27,6 +27,7 @@
 #include "libavutil/intreadwrite.h"
 #include "libavutil/mem.h"
 #include "libavutil/thread.h"
+#include "libavutil/time.h"
 
 #include "libavcodec/packet.h"
 
@@ -48,6 +49,11 @@ struct ThreadQueue {
 
     pthread_mutex_t lock;
     pthread_cond_t  cond;
+
+    // statistics, protected by lock
+    uint64_t        nb_items;
+    int64_t         send_wait;
+    int64_t         recv_wait;
 };
 
 void tq_free(ThreadQueue **ptq)
@@ -128,8 +134,14 @@ int tq_send(ThreadQueue *tq, unsigned int stream_idx, void *data)
         goto finish;
     }
 
-    while (!(*finished & FINISHED_RECV) && !av_fifo_can_write(tq->fifo_stream_index))
-        pthread_cond_wait(&tq->cond, &tq->lock);
+    if (!(*finished & FINISHED_RECV) && !av_fifo_can_write(tq->fifo_stream_index)) {
+        int64_t wait_start = av_gettime_relative();
+
+        while (!(*finished & FINISHED_RECV) && !av_fifo_can_write(tq->fifo_stream_index))
+            pthread_cond_wait(&tq->cond, &tq->lock);
+
+        tq->send_wait += av_gettime_relative() - wait_start;
+    }
 
     if (*finished & FINISHED_RECV) {
         ret = AVERROR_EOF;
@@ -143,6 +155,7 @@ int tq_send(ThreadQueue *tq, unsigned int stream_idx, void *data)
         if (ret < 0)
             goto finish;
 
+        tq->nb_items++;
         pthread_cond_broadcast(&tq->cond);
     }
 
@@ -208,7 +221,9 @@ int tq_receive(ThreadQueue *tq, int *stream_idx, void *data)
             pthread_cond_broadcast(&tq->cond);
 
         if (ret == AVERROR(EAGAIN)) {
+            int64_t wait_start = av_gettime_relative();
             pthread_cond_wait(&tq->cond, &tq->lock);
+            tq->recv_wait += av_gettime_relative() - wait_start;
             continue;
         }
 
@@ -249,3 +264,16 @@ void tq_receive_finish(ThreadQueue *tq, unsigned int stream_idx)
 
     pthread_mutex_unlock(&tq->lock);
 }
+
+void tq_stats(ThreadQueue *tq, ThreadQueueStats *stats)
+{
+    pthread_mutex_lock(&tq->lock);
+
+    stats->queued     = av_fifo_can_read(tq->fifo_stream_index);
+    stats->queue_size = stats->queued + av_fifo_can_write(tq->fifo_stream_index);
+    stats->nb_items   = tq->nb_items;
+    stats->send_wait  = tq->send_wait;
+    stats->recv_wait  = tq->recv_wait;
+
+    pthread_mutex_unlock(&tq->lock);
+}
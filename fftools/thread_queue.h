@@ -19,6 +19,7 @@
 #ifndef FFTOOLS_THREAD_QUEUE_H
 #define FFTOOLS_THREAD_QUEUE_H
 
+#include <stdint.h>
 #include <string.h>
 
 enum ThreadQueueType {
@@ -28,6 +29,19 @@ enum ThreadQueueType {
 
 typedef struct ThreadQueue ThreadQueue;
 
+typedef struct ThreadQueueStats {
+    // number of items currently in the queue
+    size_t   queued;
+    // number of items that can be stored in the queue without blocking
+    size_t   queue_size;
+    // total number of items sent to the queue
+    uint64_t nb_items;
+    // total time in microseconds spent by senders waiting for space
+    int64_t  send_wait;
+    // total time in microseconds spent by the receiver waiting for data
+    int64_t  recv_wait;
+} ThreadQueueStats;
+
 /**
  * Allocate a queue for sending data between threads.
  *
@@ -78,4 +92,9 @@ int tq_receive(ThreadQueue *tq, int *stream_idx, void *data);
  */
 void tq_receive_finish(ThreadQueue *tq, unsigned int stream_idx);
 
+/**
+ * Get a snapshot of the queue's current state and cumulative statistics.
+ */
+void tq_stats(ThreadQueue *tq, ThreadQueueStats *stats);
+
 #endif // FFTOOLS_THREAD_QUEUE_H
@@ -2028,8 +2028,25 @@ static void apply_channel_coupling(AACDecContext *ac, ChannelElement *cc,
     }
 }
 
+static int sbr_apply_job(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    AACDecContext *ac = arg;
+    ChannelElement *che = ac->sbr_che[jobnr];
+
+    ac->proc.sbr_apply(ac, che, ac->sbr_type[jobnr],
+                       che->ch[0].output,
+                       che->ch[1].output);
+    return 0;
+}
+
 /**
  * Convert spectral data to samples, applying all supported tools as appropriate.
+ *
+ * SBR/PS only touches state private to each channel element, so it is run
+ * for all elements at once via execute2(), which spreads it over the slice
+ * threads when slice threading is enabled.  Coupling after the IMDCT reads
+ * the SBR output of coupling elements and is therefore deferred until all
+ * elements have been through SBR.
  */
 static void spectral_to_sample(AACDecContext *ac, int samples)
 {
@@ -2048,6 +2065,7 @@ static void spectral_to_sample(AACDecContext *ac, int samples)
         else
             imdct_and_window = ac->dsp.imdct_and_windowing;
     }
+    ac->nb_sbr_che = 0;
     for (type = 3; type >= 0; type--) {
         for (i = 0; i < MAX_ELEM_ID; i++) {
             ChannelElement *che = ac->che[type][i];
@@ -2080,17 +2098,30 @@ static void spectral_to_sample(AACDecContext *ac, int samples)
                             ac->dsp.update_ltp(ac, &che->ch[1]);
                     }
                     if (ac->oc[1].m4ac.sbr > 0) {
-                        ac->proc.sbr_apply(ac, che, type,
-                                           che->ch[0].output,
-                                           che->ch[1].output);
+                        ac->sbr_che [ac->nb_sbr_che] = che;
+                        ac->sbr_type[ac->nb_sbr_che] = type;
+                        ac->nb_sbr_che++;
                     }
                 }
+            } else if (che) {
+                av_log(ac->avctx, AV_LOG_VERBOSE, "ChannelElement %d.%d missing \n", type, i);
+            }
+        }
+    }
+
+    if (ac->nb_sbr_che == 1)
+        sbr_apply_job(ac->avctx, ac, 0, 0);
+    else if (ac->nb_sbr_che > 1)
+        ac->avctx->execute2(ac->avctx, sbr_apply_job, ac, NULL, ac->nb_sbr_che);
+
+    for (type = 3; type >= 0; type--) {
+        for (i = 0; i < MAX_ELEM_ID; i++) {
+            ChannelElement *che = ac->che[type][i];
+            if (che && che->present) {
                 if (type <= TYPE_CCE)
                     apply_channel_coupling(ac, che, type, i, AFTER_IMDCT, ac->dsp.apply_independent_coupling);
                 ac->dsp.clip_output(ac, che, type, samples);
                 che->present = 0;
-            } else if (che) {
-                av_log(ac->avctx, AV_LOG_VERBOSE, "ChannelElement %d.%d missing \n", type, i);
             }
         }
     }
@@ -2574,7 +2605,8 @@ const FFCodec ff_aac_decoder = {
     .close           = decode_close,
     FF_CODEC_DECODE_CB(aac_decode_frame),
     CODEC_SAMPLEFMTS(AV_SAMPLE_FMT_FLTP),
-    .p.capabilities  = AV_CODEC_CAP_CHANNEL_CONF | AV_CODEC_CAP_DR1,
+    .p.capabilities  = AV_CODEC_CAP_CHANNEL_CONF | AV_CODEC_CAP_DR1 |
+                       AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal   = FF_CODEC_CAP_INIT_CLEANUP,
     CODEC_CH_LAYOUTS_ARRAY(ff_aac_ch_layout),
     .flush = flush,
@@ -2594,7 +2626,8 @@ const FFCodec ff_aac_fixed_decoder = {
     .close           = decode_close,
     FF_CODEC_DECODE_CB(aac_decode_frame),
     CODEC_SAMPLEFMTS(AV_SAMPLE_FMT_S32P),
-    .p.capabilities  = AV_CODEC_CAP_CHANNEL_CONF | AV_CODEC_CAP_DR1,
+    .p.capabilities  = AV_CODEC_CAP_CHANNEL_CONF | AV_CODEC_CAP_DR1 |
+                       AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal   = FF_CODEC_CAP_INIT_CLEANUP,
     CODEC_CH_LAYOUTS_ARRAY(ff_aac_ch_layout),
     .p.profiles      = NULL_IF_CONFIG_SMALL(ff_aac_profiles),
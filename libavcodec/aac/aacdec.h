@@ -465,6 +465,10 @@ struct AACDecContext {
     ChannelElement  *tag_che_map[4][MAX_ELEM_ID];
     int tags_mapped;
     int warned_remapping_once;
+
+    ChannelElement  *sbr_che[4 * MAX_ELEM_ID];  ///< elements awaiting SBR in the current frame
+    int              sbr_type[4 * MAX_ELEM_ID];
+    int           nb_sbr_che;
     /** @} */
 
     /**
@@ -480,6 +480,7 @@ av_cold void ff_codec_close(AVCodecContext *avctx)
 
     av_buffer_unref(&avctx->hw_frames_ctx);
     av_buffer_unref(&avctx->hw_device_ctx);
+    av_buffer_unref(&avctx->thread_pool);
 
     if (avctx->priv_data && avctx->codec && avctx->codec->priv_class)
         av_opt_free(avctx->priv_data);
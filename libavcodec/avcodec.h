@@ -1923,6 +1923,17 @@ typedef struct AVCodecContext {
      */
     AVFrameSideData  **decoded_side_data;
     int             nb_decoded_side_data;
+
+    /**
+     * A reference to an AVThreadPool (see libavutil/threadpool.h) that slice
+     * threading should run on, instead of starting threads for this context.
+     * thread_count then limits the number of threads used per call to
+     * execute()/execute2(). Frame threading is not affected.
+     *
+     * - encoding and decoding: may be set by the caller before
+     *   avcodec_open2(). Owned and freed by libavcodec afterwards.
+     */
+    AVBufferRef *thread_pool;
 } AVCodecContext;
 
 /**
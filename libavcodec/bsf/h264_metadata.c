@@ -549,6 +549,11 @@ static const CBSBSFType h264_metadata_type = {
     .update_fragment = &h264_metadata_update_fragment,
 };
 
+static const CodedBitstreamUnitType h264_metadata_decompose_types[] = {
+    H264_NAL_SPS,
+    H264_NAL_PPS,
+};
+
 static int h264_metadata_init(AVBSFContext *bsf)
 {
     H264MetadataContext *ctx = bsf->priv_data;
@@ -586,6 +591,16 @@ static int h264_metadata_init(AVBSFContext *bsf)
         }
     }
 
+    // Slices and SEI only need to be parsed to choose the AUD
+    // primary_pic_type or to edit SEI messages; otherwise pass everything
+    // but the parameter sets through without decomposing it.
+    if (ctx->aud != BSF_ELEMENT_INSERT && !ctx->sei_user_data &&
+        !ctx->delete_filler && ctx->display_orientation == BSF_ELEMENT_PASS) {
+        ctx->common.decompose_unit_types    = h264_metadata_decompose_types;
+        ctx->common.nb_decompose_unit_types =
+            FF_ARRAY_ELEMS(h264_metadata_decompose_types);
+    }
+
     return ff_cbs_bsf_generic_init(bsf, &h264_metadata_type);
 }
 
@@ -487,8 +487,24 @@ static const CBSBSFType h265_metadata_type = {
     .update_fragment = &h265_metadata_update_fragment,
 };
 
+static const CodedBitstreamUnitType h265_metadata_decompose_types[] = {
+    HEVC_NAL_VPS,
+    HEVC_NAL_SPS,
+    HEVC_NAL_PPS,
+};
+
 static int h265_metadata_init(AVBSFContext *bsf)
 {
+    H265MetadataContext *ctx = bsf->priv_data;
+
+    // Only AUD insertion needs to look inside slices; otherwise pass
+    // everything but the parameter sets through without decomposing it.
+    if (ctx->aud != BSF_ELEMENT_INSERT) {
+        ctx->common.decompose_unit_types    = h265_metadata_decompose_types;
+        ctx->common.nb_decompose_unit_types =
+            FF_ARRAY_ELEMS(h265_metadata_decompose_types);
+    }
+
     return ff_cbs_bsf_generic_init(bsf, &h265_metadata_type);
 }
 
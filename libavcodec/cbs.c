@@ -171,6 +171,8 @@ static void cbs_unit_uninit(CodedBitstreamUnit *unit)
     unit->data             = NULL;
     unit->data_size        = 0;
     unit->data_bit_padding = 0;
+    unit->raw_data         = NULL;
+    unit->raw_data_size    = 0;
 }
 
 void CBS_FUNC(fragment_reset)(CodedBitstreamFragment *frag)
@@ -417,6 +419,7 @@ static int cbs_write_unit_data(CodedBitstreamContext *ctx,
 int CBS_FUNC(write_fragment_data)(CodedBitstreamContext *ctx,
                                CodedBitstreamFragment *frag)
 {
+    AVBufferRef *old_data_ref;
     int err, i;
 
     for (i = 0; i < frag->nb_units; i++) {
@@ -426,7 +429,8 @@ int CBS_FUNC(write_fragment_data)(CodedBitstreamContext *ctx,
             continue;
 
         av_buffer_unref(&unit->data_ref);
-        unit->data = NULL;
+        unit->data     = NULL;
+        unit->raw_data = NULL;
 
         err = cbs_write_unit_data(ctx, unit);
         if (err < 0) {
@@ -437,10 +441,21 @@ int CBS_FUNC(write_fragment_data)(CodedBitstreamContext *ctx,
         av_assert0(unit->data && unit->data_ref);
     }
 
-    av_buffer_unref(&frag->data_ref);
-    frag->data = NULL;
+    // Units which were not rewritten may still point at their original
+    // coded form inside the old fragment data, so keep that alive until
+    // assembly is finished.
+    old_data_ref = frag->data_ref;
+    frag->data_ref = NULL;
+    frag->data     = NULL;
 
     err = ctx->codec->assemble_fragment(ctx, frag);
+
+    for (i = 0; i < frag->nb_units; i++) {
+        frag->units[i].raw_data      = NULL;
+        frag->units[i].raw_data_size = 0;
+    }
+    av_buffer_unref(&old_data_ref);
+
     if (err < 0) {
         av_log(ctx->log_ctx, AV_LOG_ERROR, "Failed to assemble fragment.\n");
         return err;
@@ -104,6 +104,21 @@ typedef struct CodedBitstreamUnit {
      */
     AVBufferRef *data_ref;
 
+    /**
+     * Pointer to the original coded form of this unit as it appeared in
+     * the fragment it was read from (e.g. with emulation prevention still
+     * applied), if the codec can reuse it when assembling.
+     *
+     * Only valid until the fragment data is replaced; it is cleared
+     * whenever the unit is rewritten.  Points into the fragment data
+     * buffer, so no separate reference is held.
+     */
+    const uint8_t *raw_data;
+    /**
+     * The number of bytes at raw_data.
+     */
+    size_t         raw_data_size;
+
     /**
      * Pointer to the decomposed form of this unit.
      *
@@ -57,6 +57,13 @@ typedef struct CBSBSFContext {
     CodedBitstreamContext *input;
     CodedBitstreamContext *output;
     CodedBitstreamFragment fragment;
+
+    // Unit types which update_fragment() needs in decomposed form, to be
+    // set before calling ff_cbs_bsf_generic_init().  Units of any other
+    // type are passed through in their original bitstream form without
+    // being parsed or rewritten.  If NULL, all units are decomposed.
+    const CodedBitstreamUnitType *decompose_unit_types;
+    int                           nb_decompose_unit_types;
 } CBSBSFContext;
 
 /**
@@ -495,8 +495,9 @@ static int cbs_h2645_fragment_add_nals(CodedBitstreamContext *ctx,
 
     for (i = 0; i < packet->nb_nals; i++) {
         const H2645NAL *nal = &packet->nals[i];
+        CodedBitstreamUnit *unit;
         AVBufferRef *ref;
-        size_t size = nal->size;
+        size_t size = nal->size, raw_size = nal->raw_size;
         enum AVCodecID codec_id = ctx->codec->codec_id;
 
         if (codec_id == AV_CODEC_ID_HEVC && nal->nuh_layer_id > 0 &&
@@ -518,6 +519,17 @@ static int cbs_h2645_fragment_add_nals(CodedBitstreamContext *ctx,
                             (uint8_t*)nal->data, size, ref);
         if (err < 0)
             return err;
+
+        // If every emulation prevention byte lies inside the part we keep,
+        // the escaped NAL unit can be copied back verbatim when the unit
+        // is not rewritten.
+        while (raw_size > 0 && nal->raw_data[raw_size - 1] == 0)
+            --raw_size;
+        if (nal->raw_size - raw_size == nal->size - size) {
+            unit = &frag->units[frag->nb_units - 1];
+            unit->raw_data      = nal->raw_data;
+            unit->raw_data_size = raw_size;
+        }
     }
 
     return 0;
@@ -1839,8 +1851,10 @@ static int cbs_h2645_assemble_fragment(CodedBitstreamContext *ctx,
 
     max_size = 0;
     for (i = 0; i < frag->nb_units; i++) {
+        const CodedBitstreamUnit *unit = &frag->units[i];
         // Start code + content with worst-case emulation prevention.
-        max_size += 4 + frag->units[i].data_size * 3 / 2;
+        max_size += 4 + (unit->raw_data ? unit->raw_data_size
+                                         : unit->data_size * 3 / 2);
     }
 
     data = av_realloc(NULL, max_size + AV_INPUT_BUFFER_PADDING_SIZE);
@@ -1868,6 +1882,13 @@ static int cbs_h2645_assemble_fragment(CodedBitstreamContext *ctx,
         data[dp++] = 0;
         data[dp++] = 1;
 
+        if (unit->raw_data) {
+            // Untouched unit: reuse the original escaped bytes.
+            memcpy(data + dp, unit->raw_data, unit->raw_data_size);
+            dp += unit->raw_data_size;
+            continue;
+        }
+
         zero_run = 0;
         for (sp = 0; sp < unit->data_size; sp++) {
             if (zero_run < 2) {
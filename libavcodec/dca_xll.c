@@ -628,43 +628,59 @@ static av_cold void chs_clear_band_data(DCAXllDecoder *s, DCAXllChSet *c, int ba
     }
 }
 
-static void chs_filter_band_data(DCAXllDecoder *s, DCAXllChSet *c, int band)
+static void chs_inverse_prediction(DCAXllDecoder *s, DCAXllChSet *c, int band, int ch)
 {
     DCAXllBand *b = &c->bands[band];
+    int32_t *buf = b->msb_sample_buffer[ch];
+    int order = b->adapt_pred_order[ch];
     int nsamples = s->nframesamples;
-    int i, j, k;
+    int j, k;
 
     // Inverse adaptive or fixed prediction
-    for (i = 0; i < c->nchannels; i++) {
-        int32_t *buf = b->msb_sample_buffer[i];
-        int order = b->adapt_pred_order[i];
-        if (order > 0) {
-            int coeff[DCA_XLL_ADAPT_PRED_ORDER_MAX];
-            // Conversion from reflection coefficients to direct form coefficients
-            for (j = 0; j < order; j++) {
-                int rc = b->adapt_refl_coeff[i][j];
-                for (k = 0; k < (j + 1) / 2; k++) {
-                    int tmp1 = coeff[    k    ];
-                    int tmp2 = coeff[j - k - 1];
-                    coeff[    k    ] = tmp1 + mul16(rc, tmp2);
-                    coeff[j - k - 1] = tmp2 + mul16(rc, tmp1);
-                }
-                coeff[j] = rc;
+    if (order > 0) {
+        int coeff[DCA_XLL_ADAPT_PRED_ORDER_MAX];
+        // Conversion from reflection coefficients to direct form coefficients
+        for (j = 0; j < order; j++) {
+            int rc = b->adapt_refl_coeff[ch][j];
+            for (k = 0; k < (j + 1) / 2; k++) {
+                int tmp1 = coeff[    k    ];
+                int tmp2 = coeff[j - k - 1];
+                coeff[    k    ] = tmp1 + mul16(rc, tmp2);
+                coeff[j - k - 1] = tmp2 + mul16(rc, tmp1);
             }
-            // Inverse adaptive prediction
-            for (j = 0; j < nsamples - order; j++) {
-                int64_t err = 0;
-                for (k = 0; k < order; k++)
-                    err += (int64_t)buf[j + k] * coeff[order - k - 1];
-                buf[j + k] -= (SUINT)clip23(norm16(err));
-            }
-        } else {
-            // Inverse fixed coefficient prediction
-            for (j = 0; j < b->fixed_pred_order[i]; j++)
-                for (k = 1; k < nsamples; k++)
-                    buf[k] += (unsigned)buf[k - 1];
+            coeff[j] = rc;
+        }
+        // Inverse adaptive prediction
+        for (j = 0; j < nsamples - order; j++) {
+            int64_t err = 0;
+            for (k = 0; k < order; k++)
+                err += (int64_t)buf[j + k] * coeff[order - k - 1];
+            buf[j + k] -= (SUINT)clip23(norm16(err));
         }
+    } else {
+        // Inverse fixed coefficient prediction
+        for (j = 0; j < b->fixed_pred_order[ch]; j++)
+            for (k = 1; k < nsamples; k++)
+                buf[k] += (unsigned)buf[k - 1];
     }
+}
+
+static int chs_inverse_prediction_thread(AVCodecContext *avctx, void *arg,
+                                         int jobnr, int threadnr)
+{
+    DCAXllDecoder *s = arg;
+    const uint8_t *job = s->pred_jobs[jobnr];
+
+    chs_inverse_prediction(s, &s->chset[job[0]], job[1], job[2]);
+
+    return 0;
+}
+
+static void chs_filter_band_data(DCAXllDecoder *s, DCAXllChSet *c, int band)
+{
+    DCAXllBand *b = &c->bands[band];
+    int nsamples = s->nframesamples;
+    int i;
 
     // Inverse pairwise channel decorrelation
     if (b->decor_enabled) {
@@ -1363,6 +1379,21 @@ int ff_dca_xll_filter_frame(DCAXllDecoder *s, AVFrame *frame)
         s->fixed_lsb_width = 0;
     }
 
+    // Inverse prediction runs per channel and does not depend on the
+    // other channels, so do it for all active channel sets at once
+    k = 0;
+    for (i = 0, c = s->chset; i < s->nactivechsets; i++, c++) {
+        for (j = 0; j < c->nfreqbands; j++) {
+            for (int ch = 0; ch < c->nchannels; ch++) {
+                s->pred_jobs[k][0] = i;
+                s->pred_jobs[k][1] = j;
+                s->pred_jobs[k][2] = ch;
+                k++;
+            }
+        }
+    }
+    avctx->execute2(avctx, chs_inverse_prediction_thread, s, NULL, k);
+
     // Filter frequency bands for active channel sets
     s->output_mask = 0;
     for (i = 0, c = s->chset; i < s->nactivechsets; i++, c++) {
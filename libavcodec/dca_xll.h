@@ -140,6 +140,9 @@ typedef struct DCAXllDecoder {
 
     int     output_mask;
     int32_t *output_samples[DCA_SPEAKER_COUNT];
+
+    /// (channel set, band, channel) of each inverse prediction job
+    uint8_t pred_jobs[DCA_XLL_CHSETS_MAX * DCA_XLL_BANDS_MAX * DCA_XLL_CHANNELS_MAX][3];
 } DCAXllDecoder;
 
 int ff_dca_xll_parse(DCAXllDecoder *s, const uint8_t *data, DCAExssAsset *asset);
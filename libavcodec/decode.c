@@ -39,6 +39,7 @@
 #include "libavutil/mastering_display_metadata.h"
 #include "libavutil/mem.h"
 #include "libavutil/stereo3d.h"
+#include "libavutil/trace_internal.h"
 
 #include "avcodec.h"
 #include "avcodec_internal.h"
@@ -436,7 +437,9 @@ static inline int decode_simple_internal(AVCodecContext *avctx, AVFrame *frame,
 
     frame->pict_type = dc->initial_pict_type;
     frame->flags    |= dc->intra_only_flag;
+    FF_TRACE_BEGIN(avctx->codec->name, pkt->pts);
     consumed = codec->cb.decode(avctx, frame, &got_frame, pkt);
+    FF_TRACE_END(avctx->codec->name, pkt->pts);
 
     if (!(codec->caps_internal & FF_CODEC_CAP_SETS_PKT_DTS))
         frame->pkt_dts = pkt->dts;
@@ -615,7 +618,9 @@ int ff_decode_receive_frame_internal(AVCodecContext *avctx, AVFrame *frame)
         while (1) {
             frame->pict_type = dc->initial_pict_type;
             frame->flags    |= dc->intra_only_flag;
+            FF_TRACE_BEGIN(avctx->codec->name, AV_NOPTS_VALUE);
             ret = codec->cb.receive_frame(avctx, frame);
+            FF_TRACE_END(avctx->codec->name, ret >= 0 ? frame->pts : AV_NOPTS_VALUE);
             emms_c();
             if (!ret) {
                 if (avctx->codec->type == AVMEDIA_TYPE_AUDIO) {
@@ -28,6 +28,7 @@
 #include "libavutil/mem.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/trace_internal.h"
 
 #include "avcodec.h"
 #include "avcodec_internal.h"
@@ -236,7 +237,9 @@ int ff_encode_encode_cb(AVCodecContext *avctx, AVPacket *avpkt,
     const FFCodec *const codec = ffcodec(avctx->codec);
     int ret;
 
+    FF_TRACE_BEGIN(avctx->codec->name, frame ? frame->pts : AV_NOPTS_VALUE);
     ret = codec->cb.encode(avctx, avpkt, frame, got_packet);
+    FF_TRACE_END(avctx->codec->name, frame ? frame->pts : AV_NOPTS_VALUE);
     emms_c();
     av_assert0(ret <= 0);
 
@@ -362,7 +365,9 @@ static int encode_receive_packet_internal(AVCodecContext *avctx, AVPacket *avpkt
     }
 
     if (ffcodec(avctx->codec)->cb_type == FF_CODEC_CB_TYPE_RECEIVE_PACKET) {
+        FF_TRACE_BEGIN(avctx->codec->name, AV_NOPTS_VALUE);
         ret = ffcodec(avctx->codec)->cb.receive_packet(avctx, avpkt);
+        FF_TRACE_END(avctx->codec->name, ret >= 0 ? avpkt->pts : AV_NOPTS_VALUE);
         if (ret < 0)
             av_packet_unref(avpkt);
         else
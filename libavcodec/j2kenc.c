@@ -134,6 +134,7 @@ typedef struct {
     Jpeg2000QuantStyle  qntsty;
 
     Jpeg2000Tile *tile;
+    int *tile_comp_ret; ///< per tile component tier-1 return codes
     int layer_rates[100];
     uint8_t compression_rate_enc; ///< Is compression done using compression ratio?
 
@@ -465,6 +466,10 @@ static int init_tiles(Jpeg2000EncoderContext *s)
     s->tile = av_calloc(s->numXtiles, s->numYtiles * sizeof(Jpeg2000Tile));
     if (!s->tile)
         return AVERROR(ENOMEM);
+    s->tile_comp_ret = av_calloc(s->numXtiles * s->numYtiles,
+                                 s->ncomponents * sizeof(*s->tile_comp_ret));
+    if (!s->tile_comp_ret)
+        return AVERROR(ENOMEM);
     for (tileno = 0, tiley = 0; tiley < s->numYtiles; tiley++)
         for (tilex = 0; tilex < s->numXtiles; tilex++, tileno++){
             Jpeg2000Tile *tile = s->tile + tileno;
@@ -1402,84 +1407,107 @@ static void truncpasses(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile)
     }
 }
 
-static int encode_tile(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile, int tileno)
+/**
+ * DWT and tier-1 coding of one tile component.
+ * Only touches data owned by that component, so separate tile components
+ * can be coded concurrently.
+ */
+static int encode_tile_comp(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile, int compno)
 {
-    int compno, reslevelno, bandno, ret;
+    int reslevelno, bandno, ret;
     Jpeg2000T1Context t1;
     Jpeg2000CodingStyle *codsty = &s->codsty;
-    for (compno = 0; compno < s->ncomponents; compno++){
-        Jpeg2000Component *comp = s->tile[tileno].comp + compno;
-
-        t1.stride = (1<<codsty->log2_cblk_width) + 2;
-
-        av_log(s->avctx, AV_LOG_DEBUG,"dwt\n");
-        if ((ret = ff_dwt_encode(&comp->dwt, comp->i_data)) < 0)
-            return ret;
-        av_log(s->avctx, AV_LOG_DEBUG,"after dwt -> tier1\n");
+    Jpeg2000Component *comp = tile->comp + compno;
 
-        for (reslevelno = 0; reslevelno < codsty->nreslevels; reslevelno++){
-            Jpeg2000ResLevel *reslevel = comp->reslevel + reslevelno;
+    t1.stride = (1<<codsty->log2_cblk_width) + 2;
 
-            for (bandno = 0; bandno < reslevel->nbands ; bandno++){
-                Jpeg2000Band *band = reslevel->band + bandno;
-                Jpeg2000Prec *prec = band->prec; // we support only 1 precinct per band ATM in the encoder
-                int cblkx, cblky, cblkno=0, xx0, x0, xx1, y0, yy0, yy1, bandpos;
-                yy0 = bandno == 0 ? 0 : comp->reslevel[reslevelno-1].coord[1][1] - comp->reslevel[reslevelno-1].coord[1][0];
-                y0 = yy0;
-                yy1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[1][0] + 1, band->log2_cblk_height) << band->log2_cblk_height,
-                            band->coord[1][1]) - band->coord[1][0] + yy0;
-
-                if (band->coord[0][0] == band->coord[0][1] || band->coord[1][0] == band->coord[1][1])
-                    continue;
+    av_log(s->avctx, AV_LOG_DEBUG,"dwt\n");
+    if ((ret = ff_dwt_encode(&comp->dwt, comp->i_data)) < 0)
+        return ret;
+    av_log(s->avctx, AV_LOG_DEBUG,"after dwt -> tier1\n");
 
-                bandpos = bandno + (reslevelno > 0);
-
-                for (cblky = 0; cblky < prec->nb_codeblocks_height; cblky++){
-                    if (reslevelno == 0 || bandno == 1)
-                        xx0 = 0;
-                    else
-                        xx0 = comp->reslevel[reslevelno-1].coord[0][1] - comp->reslevel[reslevelno-1].coord[0][0];
-                    x0 = xx0;
-                    xx1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[0][0] + 1, band->log2_cblk_width) << band->log2_cblk_width,
-                                band->coord[0][1]) - band->coord[0][0] + xx0;
-
-                    for (cblkx = 0; cblkx < prec->nb_codeblocks_width; cblkx++, cblkno++){
-                        int y, x;
-                        if (codsty->transform == FF_DWT53){
-                            for (y = yy0; y < yy1; y++){
-                                int *ptr = t1.data + (y-yy0)*t1.stride;
-                                for (x = xx0; x < xx1; x++){
-                                    *ptr++ = comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x] * (1 << NMSEDEC_FRACBITS);
-                                }
+    for (reslevelno = 0; reslevelno < codsty->nreslevels; reslevelno++){
+        Jpeg2000ResLevel *reslevel = comp->reslevel + reslevelno;
+
+        for (bandno = 0; bandno < reslevel->nbands ; bandno++){
+            Jpeg2000Band *band = reslevel->band + bandno;
+            Jpeg2000Prec *prec = band->prec; // we support only 1 precinct per band ATM in the encoder
+            int cblkx, cblky, cblkno=0, xx0, x0, xx1, y0, yy0, yy1, bandpos;
+            yy0 = bandno == 0 ? 0 : comp->reslevel[reslevelno-1].coord[1][1] - comp->reslevel[reslevelno-1].coord[1][0];
+            y0 = yy0;
+            yy1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[1][0] + 1, band->log2_cblk_height) << band->log2_cblk_height,
+                        band->coord[1][1]) - band->coord[1][0] + yy0;
+
+            if (band->coord[0][0] == band->coord[0][1] || band->coord[1][0] == band->coord[1][1])
+                continue;
+
+            bandpos = bandno + (reslevelno > 0);
+
+            for (cblky = 0; cblky < prec->nb_codeblocks_height; cblky++){
+                if (reslevelno == 0 || bandno == 1)
+                    xx0 = 0;
+                else
+                    xx0 = comp->reslevel[reslevelno-1].coord[0][1] - comp->reslevel[reslevelno-1].coord[0][0];
+                x0 = xx0;
+                xx1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[0][0] + 1, band->log2_cblk_width) << band->log2_cblk_width,
+                            band->coord[0][1]) - band->coord[0][0] + xx0;
+
+                for (cblkx = 0; cblkx < prec->nb_codeblocks_width; cblkx++, cblkno++){
+                    int y, x;
+                    if (codsty->transform == FF_DWT53){
+                        for (y = yy0; y < yy1; y++){
+                            int *ptr = t1.data + (y-yy0)*t1.stride;
+                            for (x = xx0; x < xx1; x++){
+                                *ptr++ = comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x] * (1 << NMSEDEC_FRACBITS);
                             }
-                        } else{
-                            for (y = yy0; y < yy1; y++){
-                                int *ptr = t1.data + (y-yy0)*t1.stride;
-                                for (x = xx0; x < xx1; x++){
-                                    *ptr = (comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x]);
-                                    *ptr = (int64_t)*ptr * (int64_t)(16384 * 65536 / band->i_stepsize) >> 15 - NMSEDEC_FRACBITS;
-                                    ptr++;
-                                }
+                        }
+                    } else{
+                        for (y = yy0; y < yy1; y++){
+                            int *ptr = t1.data + (y-yy0)*t1.stride;
+                            for (x = xx0; x < xx1; x++){
+                                *ptr = (comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x]);
+                                *ptr = (int64_t)*ptr * (int64_t)(16384 * 65536 / band->i_stepsize) >> 15 - NMSEDEC_FRACBITS;
+                                ptr++;
                             }
                         }
-                        if (!prec->cblk[cblkno].data)
-                            prec->cblk[cblkno].data = av_malloc(1 + 8192);
-                        if (!prec->cblk[cblkno].passes)
-                            prec->cblk[cblkno].passes = av_malloc_array(JPEG2000_MAX_PASSES, sizeof (*prec->cblk[cblkno].passes));
-                        if (!prec->cblk[cblkno].data || !prec->cblk[cblkno].passes)
-                            return AVERROR(ENOMEM);
-                        encode_cblk(s, &t1, prec->cblk + cblkno, tile, xx1 - xx0, yy1 - yy0,
-                                    bandpos, codsty->nreslevels - reslevelno - 1);
-                        xx0 = xx1;
-                        xx1 = FFMIN(xx1 + (1 << band->log2_cblk_width), band->coord[0][1] - band->coord[0][0] + x0);
                     }
-                    yy0 = yy1;
-                    yy1 = FFMIN(yy1 + (1 << band->log2_cblk_height), band->coord[1][1] - band->coord[1][0] + y0);
+                    if (!prec->cblk[cblkno].data)
+                        prec->cblk[cblkno].data = av_malloc(1 + 8192);
+                    if (!prec->cblk[cblkno].passes)
+                        prec->cblk[cblkno].passes = av_malloc_array(JPEG2000_MAX_PASSES, sizeof (*prec->cblk[cblkno].passes));
+                    if (!prec->cblk[cblkno].data || !prec->cblk[cblkno].passes)
+                        return AVERROR(ENOMEM);
+                    encode_cblk(s, &t1, prec->cblk + cblkno, tile, xx1 - xx0, yy1 - yy0,
+                                bandpos, codsty->nreslevels - reslevelno - 1);
+                    xx0 = xx1;
+                    xx1 = FFMIN(xx1 + (1 << band->log2_cblk_width), band->coord[0][1] - band->coord[0][0] + x0);
                 }
+                yy0 = yy1;
+                yy1 = FFMIN(yy1 + (1 << band->log2_cblk_height), band->coord[1][1] - band->coord[1][0] + y0);
             }
         }
-        av_log(s->avctx, AV_LOG_DEBUG, "after tier1\n");
     }
+    av_log(s->avctx, AV_LOG_DEBUG, "after tier1\n");
+
+    return 0;
+}
+
+static int encode_tile_comp_thread(AVCodecContext *avctx, void *arg,
+                                   int jobnr, int threadnr)
+{
+    Jpeg2000EncoderContext *s = avctx->priv_data;
+
+    return encode_tile_comp(s, s->tile + jobnr / s->ncomponents,
+                            jobnr % s->ncomponents);
+}
+
+/**
+ * Rate control and tier-2 coding of one tile, after all its components
+ * have been through encode_tile_comp().
+ */
+static int encode_tile(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile, int tileno)
+{
+    int ret;
 
     av_log(s->avctx, AV_LOG_DEBUG, "rate control\n");
     if (s->compression_rate_enc)
@@ -1498,6 +1526,7 @@ static void cleanup(Jpeg2000EncoderContext *s)
     int tileno, compno;
     Jpeg2000CodingStyle *codsty = &s->codsty;
 
+    av_freep(&s->tile_comp_ret);
     if (!s->tile)
         return;
     for (tileno = 0; tileno < s->numXtiles * s->numYtiles; tileno++){
@@ -1531,7 +1560,7 @@ static void update_size(uint8_t *size, const uint8_t *end)
 static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
                         const AVFrame *pict, int *got_packet)
 {
-    int tileno, ret;
+    int tileno, i, ret;
     Jpeg2000EncoderContext *s = avctx->priv_data;
     uint8_t *chunkstart, *jp2cstart, *jp2hstart;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(avctx->pix_fmt);
@@ -1642,6 +1671,15 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     if ((ret = put_com(s, 0)) < 0)
         return ret;
 
+    // Tier-1 coding is independent per tile component and deterministic,
+    // so do it for the whole picture up front; tier-2 coding writes the
+    // codestream and stays sequential.
+    avctx->execute2(avctx, encode_tile_comp_thread, NULL, s->tile_comp_ret,
+                    s->numXtiles * s->numYtiles * s->ncomponents);
+    for (i = 0; i < s->numXtiles * s->numYtiles * s->ncomponents; i++)
+        if (s->tile_comp_ret[i] < 0)
+            return s->tile_comp_ret[i];
+
     for (tileno = 0; tileno < s->numXtiles * s->numYtiles; tileno++){
         uint8_t *psotptr;
         if (!(psotptr = put_sot(s, tileno)))
@@ -1840,7 +1878,7 @@ const FFCodec ff_jpeg2000_encoder = {
     .p.type         = AVMEDIA_TYPE_VIDEO,
     .p.id           = AV_CODEC_ID_JPEG2000,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE |
-                      AV_CODEC_CAP_FRAME_THREADS,
+                      AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS,
     .priv_data_size = sizeof(Jpeg2000EncoderContext),
     .init           = j2kenc_init,
     FF_CODEC_ENCODE_CB(encode_frame),
@@ -2239,8 +2239,9 @@ static inline void mct_decode(const Jpeg2000DecoderContext *s, Jpeg2000Tile *til
 static inline int tile_codeblocks(const Jpeg2000DecoderContext *s, Jpeg2000Tile *tile)
 {
     Jpeg2000T1Context t1;
+    Jpeg2000HTBuffers *ht_buf = NULL;
 
-    int compno, reslevelno, bandno;
+    int compno, reslevelno, bandno, ret = 0;
 
     /* Loop on tile components */
     for (compno = 0; compno < s->ncomponents; compno++) {
@@ -2272,7 +2273,8 @@ static inline int tile_codeblocks(const Jpeg2000DecoderContext *s, Jpeg2000Tile
 
                 if ((codsty->cblk_style & JPEG2000_CTSY_HTJ2K_F) && M_b >= 31) {
                     avpriv_request_sample(s->avctx, "JPEG2000_CTSY_HTJ2K_F and M_b >= 31");
-                    return AVERROR_PATCHWELCOME;
+                    ret = AVERROR_PATCHWELCOME;
+                    goto end;
                 }
 
                 nb_precincts = rlevel->num_precincts_x * rlevel->num_precincts_y;
@@ -2284,16 +2286,21 @@ static inline int tile_codeblocks(const Jpeg2000DecoderContext *s, Jpeg2000Tile
                     for (cblkno = 0;
                          cblkno < prec->nb_codeblocks_width * prec->nb_codeblocks_height;
                          cblkno++) {
-                        int x, y, ret;
+                        int x, y;
 
                         Jpeg2000Cblk *cblk = prec->cblk + cblkno;
 
-                        if (cblk->modes & JPEG2000_CTSY_HTJ2K_F)
-                            ret = ff_jpeg2000_decode_htj2k(s, codsty, &t1, cblk,
+                        if (cblk->modes & JPEG2000_CTSY_HTJ2K_F) {
+                            // Shared by all HT code-blocks of the tile.
+                            if (!ht_buf && !(ht_buf = av_malloc(sizeof(*ht_buf)))) {
+                                ret = AVERROR(ENOMEM);
+                                goto end;
+                            }
+                            ret = ff_jpeg2000_decode_htj2k(s, codsty, &t1, ht_buf, cblk,
                                                            cblk->coord[0][1] - cblk->coord[0][0],
                                                            cblk->coord[1][1] - cblk->coord[1][0],
                                                            M_b, comp->roi_shift);
-                        else
+                        } else
                             ret = decode_cblk(s, codsty, &t1, cblk,
                                               cblk->coord[0][1] - cblk->coord[0][0],
                                               cblk->coord[1][1] - cblk->coord[1][0],
@@ -2322,7 +2329,10 @@ static inline int tile_codeblocks(const Jpeg2000DecoderContext *s, Jpeg2000Tile
             ff_dwt_decode(&comp->dwt, codsty->transform == FF_DWT97 ? (void*)comp->f_data : (void*)comp->i_data);
 
     } /*end comp */
-    return 0;
+    ret = 0;
+end:
+    av_freep(&ht_buf);
+    return ret;
 }
 
 #define WRITE_FRAME(D, PIXEL)                                                                     \
@@ -552,8 +552,11 @@ static int jpeg2000_decode_ht_cleanup_segment(const Jpeg2000DecoderContext *s,
                                               StateVars *mag_sgn_stream, const uint8_t *Dcup,
                                               uint32_t Lcup, uint32_t Pcup, uint8_t pLSB,
                                               int width, int height, const int stride,
-                                              int32_t *sample_buf, uint8_t *block_states)
+                                              Jpeg2000HTBuffers *buf)
 {
+    int32_t *sample_buf             = buf->sample_buf;
+    uint8_t *block_states           = buf->block_states;
+
     uint16_t q                      = 0;     // Represents current quad position
     uint16_t q1, q2;
     uint16_t context1, context2;
@@ -591,8 +594,8 @@ static int jpeg2000_decode_ht_cleanup_segment(const Jpeg2000DecoderContext *s,
 
     uint64_t c;
 
-    uint8_t *sigma, *sigma_n, *E;
-    uint32_t *mu, *mu_n;
+    uint8_t *sigma, *sigma_n = buf->sigma, *E = buf->E;
+    uint32_t *mu, *mu_n = buf->mu;
 
     const uint8_t *vlc_buf = Dcup + Pcup;
 
@@ -617,14 +620,10 @@ static int jpeg2000_decode_ht_cleanup_segment(const Jpeg2000DecoderContext *s,
     if (maxbp >= 32)
         return AVERROR_INVALIDDATA;
 
-    sigma_n = av_calloc(buf_size, sizeof(uint8_t));
-    E       = av_calloc(buf_size, sizeof(uint8_t));
-    mu_n    = av_calloc(buf_size, sizeof(uint32_t));
-
-    if (!sigma_n || !E || !mu_n) {
-        ret = AVERROR(ENOMEM);
-        goto free;
-    }
+    av_assert0(buf_size <= JPEG2000_HT_BUF_SIZE);
+    memset(sigma_n, 0, buf_size * sizeof(*sigma_n));
+    memset(E,       0, buf_size * sizeof(*E));
+    memset(mu_n,    0, buf_size * sizeof(*mu_n));
 
     sigma = sigma_n;
     mu = mu_n;
@@ -1007,9 +1006,6 @@ static int jpeg2000_decode_ht_cleanup_segment(const Jpeg2000DecoderContext *s,
     }
     ret = 1;
 free:
-    av_freep(&sigma_n);
-    av_freep(&E);
-    av_freep(&mu_n);
     return ret;
 }
 
@@ -1186,7 +1182,8 @@ jpeg2000_decode_magref_segment( uint16_t width, uint16_t block_height, const int
 
 
 int
-ff_jpeg2000_decode_htj2k(const Jpeg2000DecoderContext *s, Jpeg2000CodingStyle *codsty, Jpeg2000T1Context *t1, Jpeg2000Cblk *cblk,
+ff_jpeg2000_decode_htj2k(const Jpeg2000DecoderContext *s, Jpeg2000CodingStyle *codsty, Jpeg2000T1Context *t1,
+                         Jpeg2000HTBuffers *buf, Jpeg2000Cblk *cblk,
                          int width, int height, int M_b, uint8_t roi_shift)
 {
     uint8_t p0 = 0;             // 3 * p0 = Number of placeholder passes
@@ -1215,8 +1212,8 @@ ff_jpeg2000_decode_htj2k(const Jpeg2000DecoderContext *s, Jpeg2000CodingStyle *c
     int ret;
 
     /* Temporary buffers */
-    int32_t *sample_buf = NULL;
-    uint8_t *block_states = NULL;
+    int32_t *sample_buf = buf->sample_buf;
+    uint8_t *block_states = buf->block_states;
 
     int32_t n, val;             // Post-processing
     const uint32_t mask  = UINT32_MAX >> (M_b + 1); // bit mask for ROI detection
@@ -1230,6 +1227,7 @@ ff_jpeg2000_decode_htj2k(const Jpeg2000DecoderContext *s, Jpeg2000CodingStyle *c
     av_assert0(width <= 1024U && height <= 1024U);
     av_assert0(width * height <= 4096);
     av_assert0(width * height > 0);
+    av_assert0(quad_buf_width * quad_buf_height <= JPEG2000_HT_BUF_SIZE);
 
     memset(t1->data, 0, t1->stride * height * sizeof(*t1->data));
     memset(t1->flags, 0, t1->stride * (height + 2) * sizeof(*t1->flags));
@@ -1268,8 +1266,7 @@ ff_jpeg2000_decode_htj2k(const Jpeg2000DecoderContext *s, Jpeg2000CodingStyle *c
     if (Scup < 2 || Scup > Lcup || Scup > 4079) {
         av_log(s->avctx, AV_LOG_ERROR, "Cleanup pass suffix length is invalid %d\n",
                Scup);
-        ret = AVERROR_INVALIDDATA;
-        goto free;
+        return AVERROR_INVALIDDATA;
     }
     Pcup = Lcup - Scup;
 
@@ -1292,18 +1289,14 @@ ff_jpeg2000_decode_htj2k(const Jpeg2000DecoderContext *s, Jpeg2000CodingStyle *c
 
     jpeg2000_init_mel_decoder(&mel_state);
 
-    sample_buf = av_calloc(quad_buf_width * quad_buf_height, sizeof(int32_t));
-    block_states = av_calloc(quad_buf_width * quad_buf_height, sizeof(uint8_t));
+    memset(sample_buf,   0, quad_buf_width * quad_buf_height * sizeof(*sample_buf));
+    memset(block_states, 0, quad_buf_width * quad_buf_height * sizeof(*block_states));
 
-    if (!sample_buf || !block_states) {
-        ret = AVERROR(ENOMEM);
-        goto free;
-    }
     if ((ret = jpeg2000_decode_ht_cleanup_segment(s, cblk, t1, &mel_state, &mel, &vlc,
                                                   &mag_sgn, Dcup, Lcup, Pcup, pLSB, width,
-                                                  height, quad_buf_width, sample_buf, block_states)) < 0) {
+                                                  height, quad_buf_width, buf)) < 0) {
         av_log(s->avctx, AV_LOG_ERROR, "Bad HT cleanup segment\n");
-        goto free;
+        return ret;
     }
 
     if (z_blk > 1)
@@ -1315,6 +1308,13 @@ ff_jpeg2000_decode_htj2k(const Jpeg2000DecoderContext *s, Jpeg2000CodingStyle *c
                                        pLSB - 1, sample_buf, block_states);
 
     /* Reconstruct the sample values */
+    if (!roi_shift) {
+        /* Sign-magnitude samples are stored as is, so whole rows can be copied. */
+        for (int y = 0; y < height; y++)
+            memcpy(&t1->data[y * t1->stride], &sample_buf[y * quad_buf_width],
+                   width * sizeof(*sample_buf));
+        return ret;
+    }
     for (int y = 0; y < height; y++) {
         for (int x = 0; x < width; x++) {
             int32_t sign;
@@ -1324,14 +1324,11 @@ ff_jpeg2000_decode_htj2k(const Jpeg2000DecoderContext *s, Jpeg2000CodingStyle *c
             sign = val & INT32_MIN;
             val &= INT32_MAX;
             /* ROI shift, if necessary */
-            if (roi_shift && (((uint32_t)val & ~mask) == 0))
+            if (((uint32_t)val & ~mask) == 0)
                 val <<= roi_shift;
             t1->data[n] = val | sign; /* NOTE: Binary point for reconstruction value is located in 31 - M_b */
         }
     }
-free:
-    av_freep(&sample_buf);
-    av_freep(&block_states);
     return ret;
 }
 
@@ -23,12 +23,32 @@
 
 #include "jpeg2000dec.h"
 
+/**
+ * Size of the HT code-block scratch buffers: (width + 4) * (height + 4) for
+ * the most elongated code-block allowed (width * height <= 4096 and
+ * width, height <= 1024).
+ */
+#define JPEG2000_HT_BUF_SIZE ((1024 + 4) * (4 + 4))
+
+/**
+ * Scratch buffers for HT code-block decoding, allocated once by the caller
+ * and reused for every code-block instead of being allocated per block.
+ */
+typedef struct Jpeg2000HTBuffers {
+    int32_t  sample_buf[JPEG2000_HT_BUF_SIZE];
+    uint8_t  block_states[JPEG2000_HT_BUF_SIZE];
+    uint8_t  sigma[JPEG2000_HT_BUF_SIZE];
+    uint8_t  E[JPEG2000_HT_BUF_SIZE];
+    uint32_t mu[JPEG2000_HT_BUF_SIZE];
+} Jpeg2000HTBuffers;
+
 /**
  * HT Block decoder as specified in Rec. ITU-T T.814 | ISO/IEC 15444-15
  */
 
 int ff_jpeg2000_decode_htj2k(const Jpeg2000DecoderContext *s, Jpeg2000CodingStyle *codsty,
-                            Jpeg2000T1Context *t1, Jpeg2000Cblk *cblk, int width,
-                            int height, int M_b, uint8_t roi_shift);
+                            Jpeg2000T1Context *t1, Jpeg2000HTBuffers *buf,
+                            Jpeg2000Cblk *cblk, int width, int height, int M_b,
+                            uint8_t roi_shift);
 
 #endif /* AVCODEC_JPEG2000HTDEC_H */
@@ -112,6 +112,8 @@ typedef struct OpusStreamContext {
     int delayed_samples;
 
     OpusPacket packet;
+    /* start of this stream's sub-packet, NULL when draining */
+    const uint8_t *packet_data;
 
     int redundancy_idx;
 } OpusStreamContext;
@@ -473,6 +475,17 @@ finish:
     return output_samples;
 }
 
+static int opus_decode_subpacket_thread(AVCodecContext *avctx, void *arg,
+                                        int jobnr, int threadnr)
+{
+    OpusContext *c = avctx->priv_data;
+    OpusStreamContext *s = &c->streams[jobnr];
+
+    s->decoded_samples = opus_decode_subpacket(s, s->packet_data);
+
+    return FFMIN(s->decoded_samples, 0);
+}
+
 static int opus_decode_packet(AVCodecContext *avctx, AVFrame *frame,
                               int *got_frame_ptr, AVPacket *avpkt)
 {
@@ -558,10 +571,12 @@ static int opus_decode_packet(AVCodecContext *avctx, AVFrame *frame,
         s->out_size = frame->linesize[0] - ret * sizeof(float);
     }
 
-    /* decode each sub-packet */
+    /* parse the sub-packet headers */
     for (int i = 0; i < c->p.nb_streams; i++) {
         OpusStreamContext *s = &c->streams[i];
 
+        s->packet_data = buf;
+
         if (i && buf) {
             ret = ff_opus_parse_packet(&s->packet, buf, buf_size, i != c->p.nb_streams - 1);
             if (ret < 0) {
@@ -577,12 +592,6 @@ static int opus_decode_packet(AVCodecContext *avctx, AVFrame *frame,
             s->silk_samplerate = get_silk_samplerate(s->packet.config);
         }
 
-        ret = opus_decode_subpacket(&c->streams[i], buf);
-        if (ret < 0)
-            return ret;
-        s->decoded_samples = ret;
-        decoded_samples       = FFMIN(decoded_samples, ret);
-
         if (!buf)
             continue;
 
@@ -590,6 +599,21 @@ static int opus_decode_packet(AVCodecContext *avctx, AVFrame *frame,
         buf_size -= s->packet.packet_size;
     }
 
+    /* decode each sub-packet, the streams are independent */
+    if (c->p.nb_streams > 1)
+        avctx->execute2(avctx, opus_decode_subpacket_thread, NULL, NULL,
+                        c->p.nb_streams);
+    else
+        opus_decode_subpacket_thread(avctx, NULL, 0, 0);
+
+    for (int i = 0; i < c->p.nb_streams; i++) {
+        OpusStreamContext *s = &c->streams[i];
+
+        if (s->decoded_samples < 0)
+            return s->decoded_samples;
+        decoded_samples = FFMIN(decoded_samples, s->decoded_samples);
+    }
+
     /* buffer the extra samples */
     for (int i = 0; i < c->p.nb_streams; i++) {
         OpusStreamContext *s = &c->streams[i];
@@ -780,6 +804,7 @@ const FFCodec ff_opus_decoder = {
     .close           = opus_decode_close,
     FF_CODEC_DECODE_CB(opus_decode_packet),
     .flush           = opus_decode_flush,
-    .p.capabilities  = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY | AV_CODEC_CAP_CHANNEL_CONF,
+    .p.capabilities  = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY | AV_CODEC_CAP_CHANNEL_CONF |
+                       AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal   = FF_CODEC_CAP_INIT_CLEANUP,
 };
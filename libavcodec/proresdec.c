@@ -31,6 +31,7 @@
 #include "libavutil/internal.h"
 #include "libavutil/mem.h"
 #include "libavutil/mem_internal.h"
+#include "libavutil/thread.h"
 
 #include "avcodec.h"
 #include "codec_internal.h"
@@ -130,8 +131,72 @@ static void unpack_alpha_12(GetBitContext *gb, uint16_t *dst, int num_coeffs,
     }
 }
 
+static const uint8_t dc_codebook[7] = { 0x04, 0x28, 0x28, 0x4D, 0x4D, 0x70, 0x70};
+
+// adaptive codebook switching lut according to previous run/level values
+static const uint8_t run_to_cb[16] = { 0x06, 0x06, 0x05, 0x05, 0x04, 0x29, 0x29, 0x29, 0x29, 0x28, 0x28, 0x28, 0x28, 0x28, 0x28, 0x4C };
+static const uint8_t lev_to_cb[10] = { 0x04, 0x0A, 0x05, 0x06, 0x04, 0x28, 0x28, 0x28, 0x28, 0x4C };
+
+/*
+ * Direct lookup tables for the codewords of each codebook that fit in
+ * CODEWORD_LUT_BITS bits, which covers the vast majority of coefficients.
+ * Each entry is (value << 4) | length, or 0 if the codeword is longer and
+ * has to be decoded arithmetically.
+ */
+#define CODEWORD_LUT_BITS 9
+
+static uint16_t dc_lut [FF_ARRAY_ELEMS(dc_codebook)][1 << CODEWORD_LUT_BITS];
+static uint16_t run_lut[FF_ARRAY_ELEMS(run_to_cb)  ][1 << CODEWORD_LUT_BITS];
+static uint16_t lev_lut[FF_ARRAY_ELEMS(lev_to_cb)  ][1 << CODEWORD_LUT_BITS];
+
+static av_cold void init_codeword_lut(uint16_t *lut, unsigned codebook)
+{
+    unsigned switch_bits =  codebook & 3;
+    unsigned rice_order  =  codebook >> 5;
+    unsigned exp_order   = (codebook >> 2) & 7;
+
+    for (unsigned i = 0; i < 1 << CODEWORD_LUT_BITS; i++) {
+        uint32_t buf = i << (32 - CODEWORD_LUT_BITS);
+        unsigned q, len, val;
+
+        lut[i] = 0;
+        if (!buf)
+            continue;
+
+        q = 31 - av_log2(buf);
+        if (q > switch_bits) { /* exp golomb */
+            len = exp_order - switch_bits + (q << 1);
+            if (!len || len > CODEWORD_LUT_BITS)
+                continue;
+            val = (buf >> (32 - len)) - (1 << exp_order) +
+                  ((switch_bits + 1) << rice_order);
+        } else {
+            len = q + 1 + rice_order;
+            if (len > CODEWORD_LUT_BITS)
+                continue;
+            val = q << rice_order;
+            if (rice_order)
+                val += (buf << (q + 1)) >> (32 - rice_order);
+        }
+        if (val >= 1 << 12)
+            continue;
+        lut[i] = val << 4 | len;
+    }
+}
+
+static av_cold void init_codeword_luts(void)
+{
+    for (int i = 0; i < FF_ARRAY_ELEMS(dc_codebook); i++)
+        init_codeword_lut(dc_lut[i], dc_codebook[i]);
+    for (int i = 0; i < FF_ARRAY_ELEMS(run_to_cb); i++)
+        init_codeword_lut(run_lut[i], run_to_cb[i]);
+    for (int i = 0; i < FF_ARRAY_ELEMS(lev_to_cb); i++)
+        init_codeword_lut(lev_lut[i], lev_to_cb[i]);
+}
+
 static av_cold int decode_init(AVCodecContext *avctx)
 {
+    static AVOnce init_static_once = AV_ONCE_INIT;
     ProresContext *ctx = avctx->priv_data;
 
     avctx->bits_per_raw_sample = 10;
@@ -179,6 +244,8 @@ static av_cold int decode_init(AVCodecContext *avctx)
 
     ctx->pix_fmt = AV_PIX_FMT_NONE;
 
+    ff_thread_once(&init_static_once, init_codeword_luts);
+
     return 0;
 }
 
@@ -443,11 +510,24 @@ static int decode_picture_header(AVCodecContext *avctx, const uint8_t *buf, cons
         }                                                               \
     } while (0)
 
+#define DECODE_CODEWORD_LUT(val, lut, codebook, SKIP)                  \
+    do {                                                                \
+        unsigned lut_entry;                                             \
+                                                                        \
+        UPDATE_CACHE_32(re, gb);                                        \
+        lut_entry = (lut)[SHOW_UBITS(re, gb, CODEWORD_LUT_BITS)];       \
+        if (lut_entry) {                                                \
+            val = lut_entry >> 4;                                       \
+            SKIP(re, gb, lut_entry & 15);                               \
+        } else {                                                        \
+            DECODE_CODEWORD(val, codebook, SKIP);                       \
+        }                                                               \
+    } while (0)
+
 #define TOSIGNED(x) (((x) >> 1) ^ (-((x) & 1)))
 
 #define FIRST_DC_CB 0xB8
 
-static const uint8_t dc_codebook[7] = { 0x04, 0x28, 0x28, 0x4D, 0x4D, 0x70, 0x70};
 
 static av_always_inline int decode_dc_coeffs(GetBitContext *gb, int16_t *out,
                                               int blocks_per_slice)
@@ -466,7 +546,8 @@ static av_always_inline int decode_dc_coeffs(GetBitContext *gb, int16_t *out,
     code = 5;
     sign = 0;
     for (i = 1; i < blocks_per_slice; i++, out += 64) {
-        DECODE_CODEWORD(code, dc_codebook[FFMIN(code, 6U)], LAST_SKIP_BITS);
+        DECODE_CODEWORD_LUT(code, dc_lut[FFMIN(code, 6U)],
+                            dc_codebook[FFMIN(code, 6U)], LAST_SKIP_BITS);
         if(code) sign ^= -(code & 1);
         else     sign  = 0;
         prev_dc += (((code + 1) >> 1) ^ sign) - sign;
@@ -476,10 +557,6 @@ static av_always_inline int decode_dc_coeffs(GetBitContext *gb, int16_t *out,
     return 0;
 }
 
-// adaptive codebook switching lut according to previous run/level values
-static const uint8_t run_to_cb[16] = { 0x06, 0x06, 0x05, 0x05, 0x04, 0x29, 0x29, 0x29, 0x29, 0x28, 0x28, 0x28, 0x28, 0x28, 0x28, 0x4C };
-static const uint8_t lev_to_cb[10] = { 0x04, 0x0A, 0x05, 0x06, 0x04, 0x28, 0x28, 0x28, 0x28, 0x4C };
-
 static av_always_inline int decode_ac_coeffs(AVCodecContext *avctx, GetBitContext *gb,
                                              int16_t *out, int blocks_per_slice)
 {
@@ -502,14 +579,16 @@ static av_always_inline int decode_ac_coeffs(AVCodecContext *avctx, GetBitContex
         if (bits_left <= 0 || (bits_left < 32 && !SHOW_UBITS(re, gb, bits_left)))
             break;
 
-        DECODE_CODEWORD(run, run_to_cb[FFMIN(run,  15)], LAST_SKIP_BITS);
+        DECODE_CODEWORD_LUT(run, run_lut[FFMIN(run, 15)],
+                            run_to_cb[FFMIN(run, 15)], LAST_SKIP_BITS);
         pos += run + 1;
         if (pos >= max_coeffs) {
             av_log(avctx, AV_LOG_ERROR, "ac tex damaged %d, %d\n", pos, max_coeffs);
             return AVERROR_INVALIDDATA;
         }
 
-        DECODE_CODEWORD(level, lev_to_cb[FFMIN(level, 9)], SKIP_BITS);
+        DECODE_CODEWORD_LUT(level, lev_lut[FFMIN(level, 9)],
+                            lev_to_cb[FFMIN(level, 9)], SKIP_BITS);
         level += 1;
 
         i = pos >> log2_block_count;
@@ -49,6 +49,7 @@
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/thread.h"
+#include "libavutil/trace_internal.h"
 
 enum {
     /// Set when the thread is awaiting a packet.
@@ -661,10 +662,12 @@ void ff_thread_await_progress(const ThreadFrame *f, int n, int field)
         av_log(f->owner[field], AV_LOG_DEBUG,
                "thread awaiting %d field %d from %p\n", n, field, progress);
 
+    FF_TRACE_BEGIN("thread_await_progress", AV_NOPTS_VALUE);
     pthread_mutex_lock(&p->progress_mutex);
     while (atomic_load_explicit(&progress[field], memory_order_relaxed) < n)
         pthread_cond_wait(&p->progress_cond, &p->progress_mutex);
     pthread_mutex_unlock(&p->progress_mutex);
+    FF_TRACE_END("thread_await_progress", AV_NOPTS_VALUE);
 }
 
 void ff_thread_finish_setup(AVCodecContext *avctx) {
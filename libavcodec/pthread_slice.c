@@ -135,8 +135,13 @@ av_cold int ff_slice_thread_init(AVCodecContext *avctx)
     if (!c)
         return AVERROR(ENOMEM);
     mainfunc = ffcodec(avctx->codec)->caps_internal & FF_CODEC_CAP_SLICE_THREAD_HAS_MF ? &main_function : NULL;
-    thread_count = avpriv_slicethread_create(&c->thread, avctx, worker_func,
-                                             mainfunc, thread_count);
+    // the main function may wait for the workers, so it needs dedicated threads
+    if (avctx->thread_pool && !mainfunc)
+        thread_count = avpriv_slicethread_create_shared(&c->thread, avctx->thread_pool,
+                                                        avctx, worker_func, thread_count);
+    else
+        thread_count = avpriv_slicethread_create(&c->thread, avctx, worker_func,
+                                                 mainfunc, thread_count);
     if (thread_count <= 1) {
         ff_slice_thread_free(avctx);
         avctx->thread_count = 1;
@@ -25,6 +25,7 @@
 #include "threadprogress.h"
 #include "libavutil/attributes.h"
 #include "libavutil/thread.h"
+#include "libavutil/trace_internal.h"
 
 DEFINE_OFFSET_ARRAY(ThreadProgress, thread_progress, init,
                     (offsetof(ThreadProgress, progress_mutex)),
@@ -71,8 +72,10 @@ void ff_thread_progress_await(const ThreadProgress *pro_c, int n)
     if (atomic_load_explicit(&pro->progress, memory_order_acquire) >= n)
         return;
 
+    FF_TRACE_BEGIN("thread_progress_await", AV_NOPTS_VALUE);
     ff_mutex_lock(&pro->progress_mutex);
     while (atomic_load_explicit(&pro->progress, memory_order_relaxed) < n)
         ff_cond_wait(&pro->progress_cond, &pro->progress_mutex);
     ff_mutex_unlock(&pro->progress_mutex);
+    FF_TRACE_END("thread_progress_await", AV_NOPTS_VALUE);
 }
@@ -444,10 +444,37 @@ static void itx_2d(const VVCFrameContext *fc, TransformBlock *tb, const enum VVC
         return;
     }
 
+    if (nzh == 1 && trv == VVC_DCT2) {
+        // The vertical DCT-II of a lone first row gives DCT_A times that row
+        // in every row, so transform it once and replicate it.
+        for (int x = 0; x < nzw; x++)
+            tb->coeffs[x] *= DCT_A;
+        scale_clip(tb->coeffs, nzw, w, 1, shift[0], sps->log2_transform_range);
+        fc->vvcdsp.itx.itx[trh][tb->log2_tb_width - 1](tb->coeffs, 1, nzw);
+        scale(tb->coeffs, tb->coeffs, w, 1, shift[1]);
+        for (int y = 1; y < h; y++)
+            memcpy(tb->coeffs + y * w, tb->coeffs, w * sizeof(*tb->coeffs));
+        return;
+    }
+
     for (int x = 0; x < nzw; x++)
         fc->vvcdsp.itx.itx[trv][tb->log2_tb_height - 1](tb->coeffs + x, w, nzh);
     scale_clip(tb->coeffs, nzw, w, h, shift[0], sps->log2_transform_range);
 
+    if (nzw == 1 && trh == VVC_DCT2) {
+        // Likewise each row is constant if only the first column is coded.
+        const int add = 1 << (shift[1] - 1);
+
+        for (int y = 0; y < h; y++) {
+            int *row    = tb->coeffs + y * w;
+            const int v = (row[0] * DCT_A + add) >> shift[1];
+
+            for (int x = 0; x < w; x++)
+                row[x] = v;
+        }
+        return;
+    }
+
     for (int y = 0; y < h; y++)
         fc->vvcdsp.itx.itx[trh][tb->log2_tb_width - 1](tb->coeffs + y * w, 1, nzw);
     scale(tb->coeffs, tb->coeffs, w, h, shift[1]);
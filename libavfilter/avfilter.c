@@ -34,6 +34,7 @@
 #include "libavutil/pixdesc.h"
 #include "libavutil/rational.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/trace_internal.h"
 
 #include "audio.h"
 #include "avfilter.h"
@@ -1448,7 +1449,9 @@ int ff_filter_activate(AVFilterContext *filter)
     av_assert1(!(fi->p.flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC &&
                  fi->activate));
     ctxi->ready = 0;
+    FF_TRACE_BEGIN(filter->filter->name, AV_NOPTS_VALUE);
     ret = fi->activate ? fi->activate(filter) : filter_activate_default(filter);
+    FF_TRACE_END(filter->filter->name, AV_NOPTS_VALUE);
     if (ret == FFERROR_NOT_READY)
         ret = 0;
     return ret;
@@ -637,6 +637,17 @@ typedef struct AVFilterGraph {
      * avfilter_graph_config().
      */
     unsigned max_buffered_frames;
+
+    /**
+     * A reference to an AVThreadPool (see libavutil/threadpool.h) that the
+     * internal slice threading implementation should run on, instead of
+     * starting threads for this graph. nb_threads then limits the number of
+     * threads used per job. May be set by the caller before adding any
+     * filters to the filtergraph. Owned and freed by libavfilter afterwards.
+     *
+     * Scaling contexts created by filters in this graph use the same pool.
+     */
+    AVBufferRef *thread_pool;
 } AVFilterGraph;
 
 /**
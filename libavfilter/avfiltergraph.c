@@ -128,6 +128,7 @@ void avfilter_graph_free(AVFilterGraph **graphp)
         avfilter_free(graph->filters[0]);
 
     ff_graph_thread_free(graphi);
+    av_buffer_unref(&graph->thread_pool);
 
     av_freep(&graphi->sink_links);
 
@@ -75,6 +75,7 @@ typedef struct OVRequestItem {
     ie_complete_call_back_t callback;
     ie_infer_request_t *infer_request;
 #endif
+    DNNIOProcCache io_cache;
 } OVRequestItem;
 
 #define APPEND_STRING(generated_string, iterate_string)                                            \
@@ -305,15 +306,16 @@ static int fill_model_input_ov(OVModel *ov_model, OVRequestItem *request)
                 if (ov_model->model.frame_pre_proc != NULL) {
                     ov_model->model.frame_pre_proc(task->in_frame, &input, ov_model->model.filter_ctx);
                 } else {
-                    ff_proc_from_frame_to_dnn(task->in_frame, &input, ctx);
+                    ff_proc_from_frame_to_dnn(task->in_frame, &input, &request->io_cache, ctx);
                 }
             }
             break;
         case DFT_ANALYTICS_DETECT:
-            ff_frame_to_dnn_detect(task->in_frame, &input, ctx);
+            ff_frame_to_dnn_detect(task->in_frame, &input, &request->io_cache, ctx);
             break;
         case DFT_ANALYTICS_CLASSIFY:
-            ff_frame_to_dnn_classify(task->in_frame, &input, lltask->bbox_index, ctx);
+            ff_frame_to_dnn_classify(task->in_frame, &input, lltask->bbox_index,
+                                     &request->io_cache, ctx);
             break;
         default:
             av_assert0(!"should not reach here");
@@ -447,7 +449,7 @@ static void infer_completion_callback(void *args)
                 if (ov_model->model.frame_post_proc != NULL) {
                     ov_model->model.frame_post_proc(task->out_frame, outputs, ov_model->model.filter_ctx);
                 } else {
-                    ff_proc_from_dnn_to_frame(task->out_frame, outputs, ctx);
+                    ff_proc_from_dnn_to_frame(task->out_frame, outputs, &request->io_cache, ctx);
                 }
             } else {
                 task->out_frame->width =
@@ -503,6 +505,7 @@ end:
 #else
         ie_infer_request_free(&request->infer_request);
 #endif
+        ff_dnn_io_proc_cache_uninit(&request->io_cache);
         av_freep(&request);
         av_log(ctx, AV_LOG_ERROR, "Failed to push back request_queue.\n");
         return;
@@ -526,6 +529,7 @@ static void dnn_free_model_ov(DNNModel **model)
             ie_infer_request_free(&item->infer_request);
 #endif
         }
+        ff_dnn_io_proc_cache_uninit(&item->io_cache);
         av_freep(&item->lltasks);
         av_freep(&item);
     }
@@ -980,6 +984,7 @@ static int execute_model_ov(OVRequestItem *request, Queue *inferenceq)
 #else
         ie_infer_request_free(&request->infer_request);
 #endif
+        ff_dnn_io_proc_cache_uninit(&request->io_cache);
         av_freep(&request);
         return 0;
     }
@@ -1053,6 +1058,7 @@ err:
 #else
         ie_infer_request_free(&request->infer_request);
 #endif
+        ff_dnn_io_proc_cache_uninit(&request->io_cache);
         av_freep(&request);
     }
     return ret;
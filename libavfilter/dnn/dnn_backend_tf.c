@@ -62,6 +62,7 @@ typedef struct TFRequestItem {
     LastLevelTaskItem *lltask;
     TF_Status *status;
     DNNAsyncExecModule exec_module;
+    DNNIOProcCache io_cache;
 } TFRequestItem;
 
 #define OFFSET(x) offsetof(TFOptions, x)
@@ -178,6 +179,7 @@ static inline void destroy_request_item(TFRequestItem **arg) {
     av_freep(&request->lltask);
     TF_DeleteStatus(request->status);
     ff_dnn_async_module_cleanup(&request->exec_module);
+    ff_dnn_io_proc_cache_uninit(&request->io_cache);
     av_freep(arg);
 }
 
@@ -647,12 +649,12 @@ static int fill_model_input_tf(TFModel *tf_model, TFRequestItem *request) {
             if (tf_model->model.frame_pre_proc != NULL) {
                 tf_model->model.frame_pre_proc(task->in_frame, &input, tf_model->model.filter_ctx);
             } else {
-                ff_proc_from_frame_to_dnn(task->in_frame, &input, ctx);
+                ff_proc_from_frame_to_dnn(task->in_frame, &input, &request->io_cache, ctx);
             }
         }
         break;
     case DFT_ANALYTICS_DETECT:
-        ff_frame_to_dnn_detect(task->in_frame, &input, ctx);
+        ff_frame_to_dnn_detect(task->in_frame, &input, &request->io_cache, ctx);
         break;
     default:
         avpriv_report_missing_feature(ctx, "model function type %d", tf_model->model.func_type);
@@ -722,7 +724,7 @@ static void infer_completion_callback(void *args) {
             if (tf_model->model.frame_post_proc != NULL) {
                 tf_model->model.frame_post_proc(task->out_frame, outputs, tf_model->model.filter_ctx);
             } else {
-                ff_proc_from_dnn_to_frame(task->out_frame, outputs, ctx);
+                ff_proc_from_dnn_to_frame(task->out_frame, outputs, &request->io_cache, ctx);
             }
         } else {
             task->out_frame->width =
@@ -29,6 +29,7 @@
 extern "C" {
 #include "dnn_io_proc.h"
 #include "dnn_backend_common.h"
+#include "libavutil/cpu.h"
 #include "libavutil/opt.h"
 #include "libavutil/mem.h"
 #include "queue.h"
@@ -51,8 +52,10 @@ typedef struct THInferRequest {
 
 typedef struct THRequestItem {
     THInferRequest *infer_request;
-    LastLevelTaskItem *lltask;
+    LastLevelTaskItem **lltasks;
+    uint32_t lltask_count;
     DNNAsyncExecModule exec_module;
+    DNNIOProcCache io_cache;
 } THRequestItem;
 
 
@@ -60,6 +63,7 @@ typedef struct THRequestItem {
 #define FLAGS AV_OPT_FLAG_FILTERING_PARAM
 static const AVOption dnn_th_options[] = {
     { "optimize", "turn on graph executor optimization", OFFSET(optimize), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, FLAGS},
+    { "batch_size", "batch size per request", OFFSET(batch_size), AV_OPT_TYPE_INT, { .i64 = 1 }, 1, 1000, FLAGS},
     { NULL }
 };
 
@@ -107,8 +111,11 @@ static inline void destroy_request_item(THRequestItem **arg)
     item = *arg;
     th_free_request(item->infer_request);
     av_freep(&item->infer_request);
-    av_freep(&item->lltask);
+    for (uint32_t i = 0; i < item->lltask_count; i++)
+        av_freep(&item->lltasks[i]);
+    av_freep(&item->lltasks);
     ff_dnn_async_module_cleanup(&item->exec_module);
+    ff_dnn_io_proc_cache_uninit(&item->io_cache);
     av_freep(arg);
 }
 
@@ -168,13 +175,13 @@ static int fill_model_input_th(THModel *th_model, THRequestItem *request)
     DNNData input = { 0 };
     DnnContext *ctx = th_model->ctx;
     int ret, width_idx, height_idx, channel_idx;
+    size_t frame_size;
 
-    lltask = (LastLevelTaskItem *)ff_queue_pop_front(th_model->lltask_queue);
+    lltask = (LastLevelTaskItem *)ff_queue_peek_front(th_model->lltask_queue);
     if (!lltask) {
         ret = AVERROR(EINVAL);
         goto err;
     }
-    request->lltask = lltask;
     task = lltask->task;
     infer_request = request->infer_request;
 
@@ -187,30 +194,53 @@ static int fill_model_input_th(THModel *th_model, THRequestItem *request)
     channel_idx = dnn_get_channel_idx_by_layout(input.layout);
     input.dims[height_idx] = task->in_frame->height;
     input.dims[width_idx] = task->in_frame->width;
-    input.data = av_malloc(input.dims[height_idx] * input.dims[width_idx] *
-                           input.dims[channel_idx] * sizeof(float));
-    if (!input.data)
-        return AVERROR(ENOMEM);
+    frame_size = input.dims[height_idx] * input.dims[width_idx] * input.dims[channel_idx];
+
+    // gather up to batch_size tasks of the same frame size into one request
+    request->lltask_count = 0;
+    while (request->lltask_count < (uint32_t)ctx->torch_option.batch_size) {
+        lltask = (LastLevelTaskItem *)ff_queue_peek_front(th_model->lltask_queue);
+        if (!lltask ||
+            lltask->task->in_frame->width  != input.dims[width_idx] ||
+            lltask->task->in_frame->height != input.dims[height_idx])
+            break;
+        request->lltasks[request->lltask_count++] =
+            (LastLevelTaskItem *)ff_queue_pop_front(th_model->lltask_queue);
+    }
+    input.dims[0] = request->lltask_count;
+
+    input.data = av_malloc(request->lltask_count * frame_size * sizeof(float));
+    if (!input.data) {
+        ret = AVERROR(ENOMEM);
+        goto err;
+    }
     infer_request->input_tensor = new torch::Tensor();
     infer_request->output = new torch::Tensor();
 
-    switch (th_model->model.func_type) {
-    case DFT_PROCESS_FRAME:
-        input.scale = 255;
-        if (task->do_ioproc) {
-            if (th_model->model.frame_pre_proc != NULL) {
-                th_model->model.frame_pre_proc(task->in_frame, &input, th_model->model.filter_ctx);
-            } else {
-                ff_proc_from_frame_to_dnn(task->in_frame, &input, ctx);
+    for (uint32_t i = 0; i < request->lltask_count; i++) {
+        DNNData frame_input = input;
+
+        task = request->lltasks[i]->task;
+        frame_input.data = (float *)input.data + i * frame_size;
+
+        switch (th_model->model.func_type) {
+        case DFT_PROCESS_FRAME:
+            frame_input.scale = 255;
+            if (task->do_ioproc) {
+                if (th_model->model.frame_pre_proc != NULL) {
+                    th_model->model.frame_pre_proc(task->in_frame, &frame_input, th_model->model.filter_ctx);
+                } else {
+                    ff_proc_from_frame_to_dnn(task->in_frame, &frame_input, &request->io_cache, ctx);
+                }
             }
+            break;
+        default:
+            avpriv_report_missing_feature(NULL, "model function type %d", th_model->model.func_type);
+            break;
         }
-        break;
-    default:
-        avpriv_report_missing_feature(NULL, "model function type %d", th_model->model.func_type);
-        break;
     }
     *infer_request->input_tensor = torch::from_blob(input.data,
-        {1, input.dims[channel_idx], input.dims[height_idx], input.dims[width_idx]},
+        {input.dims[0], input.dims[channel_idx], input.dims[height_idx], input.dims[width_idx]},
         deleter, torch::kFloat32);
     return 0;
 
@@ -235,7 +265,7 @@ static int th_start_inference(void *args)
         return AVERROR(EINVAL);
     }
     infer_request = request->infer_request;
-    lltask = request->lltask;
+    lltask = request->lltasks[0];
     task = lltask->task;
     th_model = (THModel *)task->model;
     ctx = th_model->ctx;
@@ -262,21 +292,22 @@ static int th_start_inference(void *args)
 
 static void infer_completion_callback(void *args) {
     THRequestItem *request = (THRequestItem*)args;
-    LastLevelTaskItem *lltask = request->lltask;
+    LastLevelTaskItem *lltask = request->lltasks[0];
     TaskItem *task = lltask->task;
     DNNData outputs = { 0 };
     THInferRequest *infer_request = request->infer_request;
     THModel *th_model = (THModel *)task->model;
     torch::Tensor *output = infer_request->output;
+    size_t frame_size;
 
     c10::IntArrayRef sizes = output->sizes();
     outputs.order = DCO_RGB;
     outputs.layout = DL_NCHW;
     outputs.dt = DNN_FLOAT;
-    if (sizes.size() == 4) {
+    if (sizes.size() == 4 && sizes.at(0) >= request->lltask_count) {
         // 4 dimensions: [batch_size, channel, height, width]
         // this format of data is normally used for video frame SR
-        outputs.dims[0] = sizes.at(0); // N
+        outputs.dims[0] = 1;            // N, per frame
         outputs.dims[1] = sizes.at(1); // C
         outputs.dims[2] = sizes.at(2); // H
         outputs.dims[3] = sizes.at(3); // W
@@ -284,32 +315,43 @@ static void infer_completion_callback(void *args) {
         avpriv_report_missing_feature(th_model->ctx, "Support of this kind of model");
         goto err;
     }
-
-    switch (th_model->model.func_type) {
-    case DFT_PROCESS_FRAME:
-        if (task->do_ioproc) {
-            // Post process can only deal with CPU memory.
-            if (output->device() != torch::kCPU)
-                *output = output->to(torch::kCPU);
-            outputs.scale = 255;
-            outputs.data = output->data_ptr();
-            if (th_model->model.frame_post_proc != NULL) {
-                th_model->model.frame_post_proc(task->out_frame, &outputs, th_model->model.filter_ctx);
+    frame_size = outputs.dims[1] * outputs.dims[2] * outputs.dims[3];
+
+    // Post process can only deal with CPU memory.
+    if (output->device() != torch::kCPU)
+        *output = output->to(torch::kCPU);
+    // Frames are sliced out of the batch by offset, which needs a dense
+    // NCHW layout; this is a no-op for already contiguous outputs.
+    *output = output->contiguous();
+
+    for (uint32_t i = 0; i < request->lltask_count; i++) {
+        task = request->lltasks[i]->task;
+
+        switch (th_model->model.func_type) {
+        case DFT_PROCESS_FRAME:
+            if (task->do_ioproc) {
+                outputs.scale = 255;
+                outputs.data = (float *)output->data_ptr() + i * frame_size;
+                if (th_model->model.frame_post_proc != NULL) {
+                    th_model->model.frame_post_proc(task->out_frame, &outputs, th_model->model.filter_ctx);
+                } else {
+                    ff_proc_from_dnn_to_frame(task->out_frame, &outputs, &request->io_cache, th_model->ctx);
+                }
             } else {
-                ff_proc_from_dnn_to_frame(task->out_frame, &outputs, th_model->ctx);
+                task->out_frame->width = outputs.dims[dnn_get_width_idx_by_layout(outputs.layout)];
+                task->out_frame->height = outputs.dims[dnn_get_height_idx_by_layout(outputs.layout)];
             }
-        } else {
-            task->out_frame->width = outputs.dims[dnn_get_width_idx_by_layout(outputs.layout)];
-            task->out_frame->height = outputs.dims[dnn_get_height_idx_by_layout(outputs.layout)];
+            break;
+        default:
+            avpriv_report_missing_feature(th_model->ctx, "model function type %d", th_model->model.func_type);
+            goto err;
         }
-        break;
-    default:
-        avpriv_report_missing_feature(th_model->ctx, "model function type %d", th_model->model.func_type);
-        goto err;
+        task->inference_done++;
     }
-    task->inference_done++;
-    av_freep(&request->lltask);
 err:
+    for (uint32_t i = 0; i < request->lltask_count; i++)
+        av_freep(&request->lltasks[i]);
+    request->lltask_count = 0;
     th_free_request(infer_request);
 
     if (ff_safe_queue_push_back(th_model->request_queue, request) < 0) {
@@ -344,7 +386,11 @@ static int execute_model_th(THRequestItem *request, Queue *lltask_queue)
         goto err;
     }
     if (task->async) {
-        avpriv_report_missing_feature(th_model->ctx, "LibTorch async");
+        ret = ff_dnn_start_inference_async(th_model->ctx, &request->exec_module);
+        if (ret != 0) {
+            goto err;
+        }
+        return 0;
     } else {
         ret = th_start_inference((void *)(request));
         if (ret != 0) {
@@ -355,6 +401,9 @@ static int execute_model_th(THRequestItem *request, Queue *lltask_queue)
     }
 
 err:
+    for (uint32_t i = 0; i < request->lltask_count; i++)
+        av_freep(&request->lltasks[i]);
+    request->lltask_count = 0;
     th_free_request(request->infer_request);
     if (ff_safe_queue_push_back(th_model->request_queue, request) < 0) {
         destroy_request_item(&request);
@@ -450,29 +499,45 @@ static DNNModel *dnn_load_model_th(DnnContext *ctx, DNNFunctionType func_type, A
         goto fail;
     }
 
+    if (ctx->nireq <= 0)
+        ctx->nireq = av_cpu_count() / 2 + 1;
+
+#if !HAVE_PTHREAD_CANCEL
+    if (ctx->async) {
+        ctx->async = 0;
+        av_log(filter_ctx, AV_LOG_WARNING, "pthread is not supported, roll back to sync.\n");
+    }
+#endif
+
     th_model->request_queue = ff_safe_queue_create();
     if (!th_model->request_queue) {
         goto fail;
     }
 
-    item = (THRequestItem *)av_mallocz(sizeof(THRequestItem));
-    if (!item) {
-        goto fail;
-    }
-    item->lltask = NULL;
-    item->infer_request = th_create_inference_request();
-    if (!item->infer_request) {
-        av_log(NULL, AV_LOG_ERROR, "Failed to allocate memory for Torch inference request\n");
-        goto fail;
-    }
-    item->exec_module.start_inference = &th_start_inference;
-    item->exec_module.callback = &infer_completion_callback;
-    item->exec_module.args = item;
+    for (int i = 0; i < ctx->nireq; i++) {
+        item = (THRequestItem *)av_mallocz(sizeof(THRequestItem));
+        if (!item) {
+            goto fail;
+        }
+        item->lltasks = (LastLevelTaskItem **)av_calloc(ctx->torch_option.batch_size,
+                                                        sizeof(*item->lltasks));
+        if (!item->lltasks) {
+            goto fail;
+        }
+        item->infer_request = th_create_inference_request();
+        if (!item->infer_request) {
+            av_log(NULL, AV_LOG_ERROR, "Failed to allocate memory for Torch inference request\n");
+            goto fail;
+        }
+        item->exec_module.start_inference = &th_start_inference;
+        item->exec_module.callback = &infer_completion_callback;
+        item->exec_module.args = item;
 
-    if (ff_safe_queue_push_back(th_model->request_queue, item) < 0) {
-        goto fail;
+        if (ff_safe_queue_push_back(th_model->request_queue, item) < 0) {
+            goto fail;
+        }
+        item = NULL;
     }
-    item = NULL;
 
     th_model->task_queue = ff_queue_create();
     if (!th_model->task_queue) {
@@ -493,7 +558,6 @@ static DNNModel *dnn_load_model_th(DnnContext *ctx, DNNFunctionType func_type, A
 fail:
     if (item) {
         destroy_request_item(&item);
-        av_freep(&item);
     }
     dnn_free_model_th(&model);
     return NULL;
@@ -519,7 +583,7 @@ static int dnn_execute_model_th(const DNNModel *model, DNNExecBaseParams *exec_p
         return AVERROR(ENOMEM);
     }
 
-    ret = ff_dnn_fill_task(task, exec_params, th_model, 0, 1);
+    ret = ff_dnn_fill_task(task, exec_params, th_model, ctx->async, 1);
     if (ret != 0) {
         av_freep(&task);
         av_log(ctx, AV_LOG_ERROR, "unable to fill task.\n");
@@ -539,6 +603,24 @@ static int dnn_execute_model_th(const DNNModel *model, DNNExecBaseParams *exec_p
         return ret;
     }
 
+    if (ctx->async) {
+        // start a request once a full batch is queued, waiting for one to
+        // become free if all nireq requests are in flight
+        while (ff_queue_size(th_model->lltask_queue) >= (size_t)ctx->torch_option.batch_size) {
+            request = (THRequestItem *)ff_safe_queue_pop_front(th_model->request_queue);
+            if (!request) {
+                av_log(ctx, AV_LOG_ERROR, "unable to get infer request.\n");
+                return AVERROR(EINVAL);
+            }
+
+            ret = execute_model_th(request, th_model->lltask_queue);
+            if (ret != 0)
+                return ret;
+        }
+
+        return 0;
+    }
+
     request = (THRequestItem *)ff_safe_queue_pop_front(th_model->request_queue);
     if (!request) {
         av_log(ctx, AV_LOG_ERROR, "unable to get infer request.\n");
@@ -558,18 +640,23 @@ static int dnn_flush_th(const DNNModel *model)
 {
     THModel *th_model = (THModel *)model;
     THRequestItem *request;
+    int ret;
 
-    if (ff_queue_size(th_model->lltask_queue) == 0)
-        // no pending task need to flush
-        return 0;
+    // a request may take less than the pending tasks, e.g. when the frame
+    // size changes within a batch, so keep going until all are started
+    while (ff_queue_size(th_model->lltask_queue) != 0) {
+        request = (THRequestItem *)ff_safe_queue_pop_front(th_model->request_queue);
+        if (!request) {
+            av_log(th_model->ctx, AV_LOG_ERROR, "unable to get infer request.\n");
+            return AVERROR(EINVAL);
+        }
 
-    request = (THRequestItem *)ff_safe_queue_pop_front(th_model->request_queue);
-    if (!request) {
-        av_log(th_model->ctx, AV_LOG_ERROR, "unable to get infer request.\n");
-        return AVERROR(EINVAL);
+        ret = execute_model_th(request, th_model->lltask_queue);
+        if (ret != 0)
+            return ret;
     }
 
-    return execute_model_th(request, th_model->lltask_queue);
+    return 0;
 }
 
 extern const DNNModule ff_dnn_backend_torch = {
@@ -23,6 +23,7 @@
 #include "libavutil/mem.h"
 #include "libswscale/swscale.h"
 #include "libavutil/avassert.h"
+#include "libavutil/common.h"
 #include "libavutil/detection_bbox.h"
 
 static int get_datatype_size(DNNDataType dt)
@@ -39,15 +40,87 @@ static int get_datatype_size(DNNDataType dt)
     }
 }
 
-int ff_proc_from_dnn_to_frame(AVFrame *frame, DNNData *output, void *log_ctx)
+static struct SwsContext *get_sws_context(struct SwsContext **cached,
+                                          int src_w, int src_h, enum AVPixelFormat src_fmt,
+                                          int dst_w, int dst_h, enum AVPixelFormat dst_fmt,
+                                          int flags, void *log_ctx)
+{
+    *cached = sws_getCachedContext(*cached, src_w, src_h, src_fmt,
+                                   dst_w, dst_h, dst_fmt,
+                                   flags, NULL, NULL, NULL);
+    if (!*cached)
+        av_log(log_ctx, AV_LOG_ERROR, "Impossible to create scale context for the conversion "
+               "fmt:%s s:%dx%d -> fmt:%s s:%dx%d\n",
+               av_get_pix_fmt_name(src_fmt), src_w, src_h,
+               av_get_pix_fmt_name(dst_fmt), dst_w, dst_h);
+    return *cached;
+}
+
+/*
+ * Convert between a packed RGB24/BGR24 frame and NCHW planes in one pass.
+ * The planes follow the packed component order, float data is scaled the
+ * same way as the GRAY8 <-> GRAYF32 conversion in swscale.
+ */
+static void packed_to_nchw(DNNData *input, const AVFrame *frame)
+{
+    const int plane_size = frame->width * frame->height;
+
+    for (int y = 0; y < frame->height; y++) {
+        const uint8_t *src = frame->data[0] + y * frame->linesize[0];
+        if (input->dt == DNN_FLOAT) {
+            float *dst = (float *)input->data + y * frame->width;
+            for (int x = 0; x < frame->width; x++) {
+                dst[x]                  = src[3 * x    ] * (1.0f / 255.0f);
+                dst[x + plane_size]     = src[3 * x + 1] * (1.0f / 255.0f);
+                dst[x + plane_size * 2] = src[3 * x + 2] * (1.0f / 255.0f);
+            }
+        } else {
+            uint8_t *dst = (uint8_t *)input->data + y * frame->width;
+            for (int x = 0; x < frame->width; x++) {
+                dst[x]                  = src[3 * x    ];
+                dst[x + plane_size]     = src[3 * x + 1];
+                dst[x + plane_size * 2] = src[3 * x + 2];
+            }
+        }
+    }
+}
+
+static void nchw_to_packed(AVFrame *frame, const DNNData *output)
+{
+    const int plane_size = frame->width * frame->height;
+
+    for (int y = 0; y < frame->height; y++) {
+        uint8_t *dst = frame->data[0] + y * frame->linesize[0];
+        if (output->dt == DNN_FLOAT) {
+            const float *src = (const float *)output->data + y * frame->width;
+            for (int x = 0; x < frame->width; x++) {
+                dst[3 * x    ] = av_clip_uint8(lrintf(255.0f * src[x]));
+                dst[3 * x + 1] = av_clip_uint8(lrintf(255.0f * src[x + plane_size]));
+                dst[3 * x + 2] = av_clip_uint8(lrintf(255.0f * src[x + plane_size * 2]));
+            }
+        } else {
+            const uint8_t *src = (const uint8_t *)output->data + y * frame->width;
+            for (int x = 0; x < frame->width; x++) {
+                dst[3 * x    ] = src[x];
+                dst[3 * x + 1] = src[x + plane_size];
+                dst[3 * x + 2] = src[x + plane_size * 2];
+            }
+        }
+    }
+}
+
+void ff_dnn_io_proc_cache_uninit(DNNIOProcCache *cache)
+{
+    sws_freeContext(cache->frame_to_dnn);
+    sws_freeContext(cache->dnn_to_frame);
+    cache->frame_to_dnn = NULL;
+    cache->dnn_to_frame = NULL;
+}
+
+int ff_proc_from_dnn_to_frame(AVFrame *frame, DNNData *output,
+                              DNNIOProcCache *cache, void *log_ctx)
 {
     struct SwsContext *sws_ctx;
-    int ret = 0;
-    int linesize[4] = { 0 };
-    void **dst_data = NULL;
-    void *middle_data = NULL;
-    uint8_t *planar_data[4] = { 0 };
-    int plane_size = frame->width * frame->height * sizeof(uint8_t);
     enum AVPixelFormat src_fmt = AV_PIX_FMT_NONE;
     int src_datatype_size = get_datatype_size(output->dt);
 
@@ -68,73 +141,23 @@ int ff_proc_from_dnn_to_frame(AVFrame *frame, DNNData *output, void *log_ctx)
         return AVERROR(ENOSYS);
     }
 
-    dst_data = (void **)frame->data;
-    linesize[0] = frame->linesize[0];
-    if (output->layout == DL_NCHW) {
-        middle_data = av_malloc(plane_size * output->dims[1]);
-        if (!middle_data) {
-            ret = AVERROR(ENOMEM);
-            goto err;
-        }
-        dst_data = &middle_data;
-        linesize[0] = frame->width * 3;
-    }
-
     switch (frame->format) {
     case AV_PIX_FMT_RGB24:
     case AV_PIX_FMT_BGR24:
-        sws_ctx = sws_getContext(frame->width * 3,
-                                 frame->height,
-                                 src_fmt,
-                                 frame->width * 3,
-                                 frame->height,
-                                 AV_PIX_FMT_GRAY8,
-                                 0, NULL, NULL, NULL);
-        if (!sws_ctx) {
-            av_log(log_ctx, AV_LOG_ERROR, "Impossible to create scale context for the conversion "
-                "fmt:%s s:%dx%d -> fmt:%s s:%dx%d\n",
-                av_get_pix_fmt_name(src_fmt), frame->width * 3, frame->height,
-                av_get_pix_fmt_name(AV_PIX_FMT_GRAY8),   frame->width * 3, frame->height);
-            ret = AVERROR(EINVAL);
-            goto err;
-        }
-        sws_scale(sws_ctx, (const uint8_t *[4]){(const uint8_t *)output->data, 0, 0, 0},
-                           (const int[4]){frame->width * 3 * src_datatype_size, 0, 0, 0}, 0, frame->height,
-                           (uint8_t * const*)dst_data, linesize);
-        sws_freeContext(sws_ctx);
         // convert data from planar to packed
         if (output->layout == DL_NCHW) {
-            sws_ctx = sws_getContext(frame->width,
-                                     frame->height,
-                                     AV_PIX_FMT_GBRP,
-                                     frame->width,
-                                     frame->height,
-                                     frame->format,
-                                     0, NULL, NULL, NULL);
-            if (!sws_ctx) {
-                av_log(log_ctx, AV_LOG_ERROR, "Impossible to create scale context for the conversion "
-                       "fmt:%s s:%dx%d -> fmt:%s s:%dx%d\n",
-                       av_get_pix_fmt_name(AV_PIX_FMT_GBRP), frame->width, frame->height,
-                       av_get_pix_fmt_name(frame->format),frame->width, frame->height);
-                ret = AVERROR(EINVAL);
-                goto err;
-            }
-            if (frame->format == AV_PIX_FMT_RGB24) {
-                planar_data[0] = (uint8_t *)middle_data + plane_size;
-                planar_data[1] = (uint8_t *)middle_data + plane_size * 2;
-                planar_data[2] = (uint8_t *)middle_data;
-            } else if (frame->format == AV_PIX_FMT_BGR24) {
-                planar_data[0] = (uint8_t *)middle_data + plane_size;
-                planar_data[1] = (uint8_t *)middle_data;
-                planar_data[2] = (uint8_t *)middle_data + plane_size * 2;
-            }
-            sws_scale(sws_ctx, (const uint8_t * const *)planar_data,
-                      (const int [4]){frame->width * sizeof(uint8_t),
-                                      frame->width * sizeof(uint8_t),
-                                      frame->width * sizeof(uint8_t), 0},
-                      0, frame->height, frame->data, frame->linesize);
-            sws_freeContext(sws_ctx);
+            nchw_to_packed(frame, output);
+            break;
         }
+        sws_ctx = get_sws_context(&cache->dnn_to_frame,
+                                  frame->width * 3, frame->height, src_fmt,
+                                  frame->width * 3, frame->height, AV_PIX_FMT_GRAY8,
+                                  0, log_ctx);
+        if (!sws_ctx)
+            return AVERROR(EINVAL);
+        sws_scale(sws_ctx, (const uint8_t *[4]){(const uint8_t *)output->data, 0, 0, 0},
+                           (const int[4]){frame->width * 3 * src_datatype_size, 0, 0, 0}, 0, frame->height,
+                           (uint8_t * const*)frame->data, frame->linesize);
         break;
     case AV_PIX_FMT_GRAYF32:
         av_image_copy_plane(frame->data[0], frame->linesize[0],
@@ -148,46 +171,28 @@ int ff_proc_from_dnn_to_frame(AVFrame *frame, DNNData *output, void *log_ctx)
     case AV_PIX_FMT_YUV411P:
     case AV_PIX_FMT_GRAY8:
     case AV_PIX_FMT_NV12:
-        sws_ctx = sws_getContext(frame->width,
-                                 frame->height,
-                                 AV_PIX_FMT_GRAYF32,
-                                 frame->width,
-                                 frame->height,
-                                 AV_PIX_FMT_GRAY8,
-                                 0, NULL, NULL, NULL);
-        if (!sws_ctx) {
-            av_log(log_ctx, AV_LOG_ERROR, "Impossible to create scale context for the conversion "
-                "fmt:%s s:%dx%d -> fmt:%s s:%dx%d\n",
-                av_get_pix_fmt_name(src_fmt), frame->width, frame->height,
-                av_get_pix_fmt_name(AV_PIX_FMT_GRAY8),   frame->width, frame->height);
-            ret = AVERROR(EINVAL);
-            goto err;
-        }
+        sws_ctx = get_sws_context(&cache->dnn_to_frame,
+                                  frame->width, frame->height, AV_PIX_FMT_GRAYF32,
+                                  frame->width, frame->height, AV_PIX_FMT_GRAY8,
+                                  0, log_ctx);
+        if (!sws_ctx)
+            return AVERROR(EINVAL);
         sws_scale(sws_ctx, (const uint8_t *[4]){(const uint8_t *)output->data, 0, 0, 0},
                            (const int[4]){frame->width * src_datatype_size, 0, 0, 0}, 0, frame->height,
                            (uint8_t * const*)frame->data, frame->linesize);
-        sws_freeContext(sws_ctx);
         break;
     default:
         avpriv_report_missing_feature(log_ctx, "%s", av_get_pix_fmt_name(frame->format));
-        ret = AVERROR(ENOSYS);
-        goto err;
+        return AVERROR(ENOSYS);
     }
 
-err:
-    av_free(middle_data);
-    return ret;
+    return 0;
 }
 
-int ff_proc_from_frame_to_dnn(AVFrame *frame, DNNData *input, void *log_ctx)
+int ff_proc_from_frame_to_dnn(AVFrame *frame, DNNData *input,
+                              DNNIOProcCache *cache, void *log_ctx)
 {
     struct SwsContext *sws_ctx;
-    int ret = 0;
-    int linesize[4] = { 0 };
-    void **src_data = NULL;
-    void *middle_data = NULL;
-    uint8_t *planar_data[4] = { 0 };
-    int plane_size = frame->width * frame->height * sizeof(uint8_t);
     enum AVPixelFormat dst_fmt = AV_PIX_FMT_NONE;
     int dst_datatype_size = get_datatype_size(input->dt);
     int bytewidth = av_image_get_linesize(frame->format, frame->width, 0);
@@ -207,74 +212,24 @@ int ff_proc_from_frame_to_dnn(AVFrame *frame, DNNData *input, void *log_ctx)
         return AVERROR(ENOSYS);
     }
 
-    src_data = (void **)frame->data;
-    linesize[0] = frame->linesize[0];
-    if (input->layout == DL_NCHW) {
-        middle_data = av_malloc(plane_size * input->dims[1]);
-        if (!middle_data) {
-            ret = AVERROR(ENOMEM);
-            goto err;
-        }
-        src_data = &middle_data;
-        linesize[0] = frame->width * 3;
-    }
-
     switch (frame->format) {
     case AV_PIX_FMT_RGB24:
     case AV_PIX_FMT_BGR24:
-        // convert data from planar to packed
+        // convert data from packed to planar
         if (input->layout == DL_NCHW) {
-            sws_ctx = sws_getContext(frame->width,
-                                     frame->height,
-                                     frame->format,
-                                     frame->width,
-                                     frame->height,
-                                     AV_PIX_FMT_GBRP,
-                                     0, NULL, NULL, NULL);
-            if (!sws_ctx) {
-                av_log(log_ctx, AV_LOG_ERROR, "Impossible to create scale context for the conversion "
-                       "fmt:%s s:%dx%d -> fmt:%s s:%dx%d\n",
-                       av_get_pix_fmt_name(frame->format), frame->width, frame->height,
-                       av_get_pix_fmt_name(AV_PIX_FMT_GBRP),frame->width, frame->height);
-                ret = AVERROR(EINVAL);
-                goto err;
-            }
-            if (frame->format == AV_PIX_FMT_RGB24) {
-                planar_data[0] = (uint8_t *)middle_data + plane_size;
-                planar_data[1] = (uint8_t *)middle_data + plane_size * 2;
-                planar_data[2] = (uint8_t *)middle_data;
-            } else if (frame->format == AV_PIX_FMT_BGR24) {
-                planar_data[0] = (uint8_t *)middle_data + plane_size;
-                planar_data[1] = (uint8_t *)middle_data;
-                planar_data[2] = (uint8_t *)middle_data + plane_size * 2;
-            }
-            sws_scale(sws_ctx, (const uint8_t * const *)frame->data,
-                      frame->linesize, 0, frame->height, planar_data,
-                      (const int [4]){frame->width * sizeof(uint8_t),
-                                      frame->width * sizeof(uint8_t),
-                                      frame->width * sizeof(uint8_t), 0});
-            sws_freeContext(sws_ctx);
+            packed_to_nchw(input, frame);
+            break;
         }
-        sws_ctx = sws_getContext(frame->width * 3,
-                                 frame->height,
-                                 AV_PIX_FMT_GRAY8,
-                                 frame->width * 3,
-                                 frame->height,
-                                 dst_fmt,
-                                 0, NULL, NULL, NULL);
-        if (!sws_ctx) {
-            av_log(log_ctx, AV_LOG_ERROR, "Impossible to create scale context for the conversion "
-                "fmt:%s s:%dx%d -> fmt:%s s:%dx%d\n",
-                av_get_pix_fmt_name(AV_PIX_FMT_GRAY8),  frame->width * 3, frame->height,
-                av_get_pix_fmt_name(dst_fmt),frame->width * 3, frame->height);
-            ret = AVERROR(EINVAL);
-            goto err;
-        }
-        sws_scale(sws_ctx, (const uint8_t **)src_data,
-                           linesize, 0, frame->height,
+        sws_ctx = get_sws_context(&cache->frame_to_dnn,
+                                  frame->width * 3, frame->height, AV_PIX_FMT_GRAY8,
+                                  frame->width * 3, frame->height, dst_fmt,
+                                  0, log_ctx);
+        if (!sws_ctx)
+            return AVERROR(EINVAL);
+        sws_scale(sws_ctx, (const uint8_t **)frame->data,
+                           frame->linesize, 0, frame->height,
                            (uint8_t * const [4]){input->data, 0, 0, 0},
                            (const int [4]){frame->width * 3 * dst_datatype_size, 0, 0, 0});
-        sws_freeContext(sws_ctx);
         break;
     case AV_PIX_FMT_GRAYF32:
         av_image_copy_plane(input->data, bytewidth,
@@ -288,35 +243,23 @@ int ff_proc_from_frame_to_dnn(AVFrame *frame, DNNData *input, void *log_ctx)
     case AV_PIX_FMT_YUV411P:
     case AV_PIX_FMT_GRAY8:
     case AV_PIX_FMT_NV12:
-        sws_ctx = sws_getContext(frame->width,
-                                 frame->height,
-                                 AV_PIX_FMT_GRAY8,
-                                 frame->width,
-                                 frame->height,
-                                 dst_fmt,
-                                 0, NULL, NULL, NULL);
-        if (!sws_ctx) {
-            av_log(log_ctx, AV_LOG_ERROR, "Impossible to create scale context for the conversion "
-                "fmt:%s s:%dx%d -> fmt:%s s:%dx%d\n",
-                av_get_pix_fmt_name(AV_PIX_FMT_GRAY8),  frame->width, frame->height,
-                av_get_pix_fmt_name(dst_fmt),frame->width, frame->height);
-            ret = AVERROR(EINVAL);
-            goto err;
-        }
+        sws_ctx = get_sws_context(&cache->frame_to_dnn,
+                                  frame->width, frame->height, AV_PIX_FMT_GRAY8,
+                                  frame->width, frame->height, dst_fmt,
+                                  0, log_ctx);
+        if (!sws_ctx)
+            return AVERROR(EINVAL);
         sws_scale(sws_ctx, (const uint8_t **)frame->data,
                            frame->linesize, 0, frame->height,
                            (uint8_t * const [4]){input->data, 0, 0, 0},
                            (const int [4]){frame->width * dst_datatype_size, 0, 0, 0});
-        sws_freeContext(sws_ctx);
         break;
     default:
         avpriv_report_missing_feature(log_ctx, "%s", av_get_pix_fmt_name(frame->format));
-        ret = AVERROR(ENOSYS);
-        goto err;
+        return AVERROR(ENOSYS);
     }
-err:
-    av_free(middle_data);
-    return ret;
+
+    return 0;
 }
 
 static enum AVPixelFormat get_pixel_format(DNNData *data)
@@ -337,7 +280,8 @@ static enum AVPixelFormat get_pixel_format(DNNData *data)
     return AV_PIX_FMT_BGR24;
 }
 
-int ff_frame_to_dnn_classify(AVFrame *frame, DNNData *input, uint32_t bbox_index, void *log_ctx)
+int ff_frame_to_dnn_classify(AVFrame *frame, DNNData *input, uint32_t bbox_index,
+                             DNNIOProcCache *cache, void *log_ctx)
 {
     const AVPixFmtDescriptor *desc;
     int offsetx[4], offsety[4];
@@ -379,24 +323,17 @@ int ff_frame_to_dnn_classify(AVFrame *frame, DNNData *input, uint32_t bbox_index
     height = bbox->h;
 
     fmt = get_pixel_format(input);
-    sws_ctx = sws_getContext(width, height, frame->format,
-                             input->dims[width_idx],
-                             input->dims[height_idx], fmt,
-                             SWS_FAST_BILINEAR, NULL, NULL, NULL);
-    if (!sws_ctx) {
-        av_log(log_ctx, AV_LOG_ERROR, "Failed to create scale context for the conversion "
-               "fmt:%s s:%dx%d -> fmt:%s s:%dx%d\n",
-               av_get_pix_fmt_name(frame->format), width, height,
-               av_get_pix_fmt_name(fmt),
-               input->dims[width_idx],
-               input->dims[height_idx]);
+    // only the bounding box is scaled, the context is reused for equally sized boxes
+    sws_ctx = get_sws_context(&cache->frame_to_dnn,
+                              width, height, frame->format,
+                              input->dims[width_idx], input->dims[height_idx], fmt,
+                              SWS_FAST_BILINEAR, log_ctx);
+    if (!sws_ctx)
         return AVERROR(EINVAL);
-    }
 
     ret = av_image_fill_linesizes(linesizes, fmt, input->dims[width_idx]);
     if (ret < 0) {
         av_log(log_ctx, AV_LOG_ERROR, "unable to get linesizes with av_image_fill_linesizes");
-        sws_freeContext(sws_ctx);
         return ret;
     }
 
@@ -415,12 +352,11 @@ int ff_frame_to_dnn_classify(AVFrame *frame, DNNData *input, uint32_t bbox_index
                        0, height,
                        (uint8_t *const [4]){input->data, 0, 0, 0}, linesizes);
 
-    sws_freeContext(sws_ctx);
-
     return ret;
 }
 
-int ff_frame_to_dnn_detect(AVFrame *frame, DNNData *input, void *log_ctx)
+int ff_frame_to_dnn_detect(AVFrame *frame, DNNData *input,
+                           DNNIOProcCache *cache, void *log_ctx)
 {
     struct SwsContext *sws_ctx;
     int linesizes[4];
@@ -443,29 +379,21 @@ int ff_frame_to_dnn_detect(AVFrame *frame, DNNData *input, void *log_ctx)
     width_idx = dnn_get_width_idx_by_layout(input->layout);
     height_idx = dnn_get_height_idx_by_layout(input->layout);
 
-    sws_ctx = sws_getContext(frame->width, frame->height, frame->format,
-                             input->dims[width_idx],
-                             input->dims[height_idx], fmt,
-                             SWS_FAST_BILINEAR, NULL, NULL, NULL);
-    if (!sws_ctx) {
-        av_log(log_ctx, AV_LOG_ERROR, "Impossible to create scale context for the conversion "
-            "fmt:%s s:%dx%d -> fmt:%s s:%dx%d\n",
-            av_get_pix_fmt_name(frame->format), frame->width, frame->height,
-            av_get_pix_fmt_name(fmt), input->dims[width_idx],
-            input->dims[height_idx]);
+    sws_ctx = get_sws_context(&cache->frame_to_dnn,
+                              frame->width, frame->height, frame->format,
+                              input->dims[width_idx], input->dims[height_idx], fmt,
+                              SWS_FAST_BILINEAR, log_ctx);
+    if (!sws_ctx)
         return AVERROR(EINVAL);
-    }
 
     ret = av_image_fill_linesizes(linesizes, fmt, input->dims[width_idx]);
     if (ret < 0) {
         av_log(log_ctx, AV_LOG_ERROR, "unable to get linesizes with av_image_fill_linesizes");
-        sws_freeContext(sws_ctx);
         return ret;
     }
 
     sws_scale(sws_ctx, (const uint8_t *const *)frame->data, frame->linesize, 0, frame->height,
                        (uint8_t *const [4]){input->data, 0, 0, 0}, linesizes);
 
-    sws_freeContext(sws_ctx);
     return ret;
 }
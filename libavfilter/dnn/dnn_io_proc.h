@@ -30,9 +30,27 @@
 #include "../dnn_interface.h"
 #include "libavutil/frame.h"
 
-int ff_proc_from_frame_to_dnn(AVFrame *frame, DNNData *input, void *log_ctx);
-int ff_proc_from_dnn_to_frame(AVFrame *frame, DNNData *output, void *log_ctx);
-int ff_frame_to_dnn_detect(AVFrame *frame, DNNData *input, void *log_ctx);
-int ff_frame_to_dnn_classify(AVFrame *frame, DNNData *input, uint32_t bbox_index, void *log_ctx);
+struct SwsContext;
+
+/**
+ * Conversion state reused across calls, so that scale contexts are only
+ * set up again when the frame or tensor geometry changes. It must be
+ * zero-initialized and is not thread-safe, backends keep one per request.
+ */
+typedef struct DNNIOProcCache {
+    struct SwsContext *frame_to_dnn;
+    struct SwsContext *dnn_to_frame;
+} DNNIOProcCache;
+
+void ff_dnn_io_proc_cache_uninit(DNNIOProcCache *cache);
+
+int ff_proc_from_frame_to_dnn(AVFrame *frame, DNNData *input,
+                              DNNIOProcCache *cache, void *log_ctx);
+int ff_proc_from_dnn_to_frame(AVFrame *frame, DNNData *output,
+                              DNNIOProcCache *cache, void *log_ctx);
+int ff_frame_to_dnn_detect(AVFrame *frame, DNNData *input,
+                           DNNIOProcCache *cache, void *log_ctx);
+int ff_frame_to_dnn_classify(AVFrame *frame, DNNData *input, uint32_t bbox_index,
+                             DNNIOProcCache *cache, void *log_ctx);
 
 #endif
@@ -136,6 +136,7 @@ typedef struct OVOptions {
 typedef struct THOptions {
     const AVClass *clazz;
     int optimize;
+    int batch_size;
 } THOptions;
 
 typedef struct DNNModule DNNModule;
@@ -73,7 +73,11 @@ static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
 
 static int thread_init_internal(ThreadContext *c, int nb_threads)
 {
-    nb_threads = avpriv_slicethread_create(&c->thread, c, worker_func, NULL, nb_threads);
+    if (c->graph->thread_pool)
+        nb_threads = avpriv_slicethread_create_shared(&c->thread, c->graph->thread_pool,
+                                                      c, worker_func, nb_threads);
+    else
+        nb_threads = avpriv_slicethread_create(&c->thread, c, worker_func, NULL, nb_threads);
     if (nb_threads <= 1)
         avpriv_slicethread_free(&c->thread);
     return FFMAX(nb_threads, 1);
@@ -82,6 +86,7 @@ static int thread_init_internal(ThreadContext *c, int nb_threads)
 int ff_graph_thread_init(FFFilterGraph *graphi)
 {
     AVFilterGraph *graph = &graphi->p;
+    ThreadContext *c;
     int ret;
 
     if (graph->nb_threads == 1) {
@@ -89,11 +94,12 @@ int ff_graph_thread_init(FFFilterGraph *graphi)
         return 0;
     }
 
-    graphi->thread = av_mallocz(sizeof(ThreadContext));
-    if (!graphi->thread)
+    c = graphi->thread = av_mallocz(sizeof(ThreadContext));
+    if (!c)
         return AVERROR(ENOMEM);
+    c->graph = graph;
 
-    ret = thread_init_internal(graphi->thread, graph->nb_threads);
+    ret = thread_init_internal(c, graph->nb_threads);
     if (ret <= 1) {
         av_freep(&graphi->thread);
         graph->thread_type = 0;
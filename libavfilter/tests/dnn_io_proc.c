@@ -0,0 +1,181 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Check that the direct packed <-> NCHW conversions give the same result as
+ * converting the packed data with swscale and (de)interleaving the planes.
+ */
+
+#include "libavutil/frame.h"
+#include "libavutil/lfg.h"
+#include "libavfilter/dnn/dnn_io_proc.c"
+
+#define W 37
+#define H 11
+
+static int sws_convert(const void *src, int src_stride, enum AVPixelFormat src_fmt,
+                       void *dst, int dst_stride, enum AVPixelFormat dst_fmt)
+{
+    struct SwsContext *sws = sws_getContext(W * 3, H, src_fmt, W * 3, H, dst_fmt,
+                                            0, NULL, NULL, NULL);
+    if (!sws)
+        return AVERROR(ENOMEM);
+    sws_scale(sws, (const uint8_t *[4]){ src }, (const int[4]){ src_stride }, 0, H,
+              (uint8_t *[4]){ dst }, (const int[4]){ dst_stride });
+    sws_freeContext(sws);
+    return 0;
+}
+
+static int test_frame_to_dnn(AVFrame *frame, DNNDataType dt, DNNIOProcCache *cache)
+{
+    const int size = dt == DNN_FLOAT ? sizeof(float) : 1;
+    uint8_t *packed = av_malloc(W * H * 3 * size);
+    uint8_t *ref    = av_malloc(W * H * 3 * size);
+    uint8_t *out    = av_malloc(W * H * 3 * size);
+    DNNData input = {
+        .data   = out,
+        .dims   = { 1, 3, H, W },
+        .layout = DL_NCHW,
+        .dt     = dt,
+        .scale  = dt == DNN_FLOAT ? 255 : 1,
+    };
+    int ret;
+
+    if (!packed || !ref || !out) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    ret = sws_convert(frame->data[0], frame->linesize[0], AV_PIX_FMT_GRAY8, packed, W * 3 * size,
+                      dt == DNN_FLOAT ? AV_PIX_FMT_GRAYF32 : AV_PIX_FMT_GRAY8);
+    if (ret < 0)
+        goto end;
+    for (int c = 0; c < 3; c++)
+        for (int i = 0; i < W * H; i++)
+            memcpy(ref + (c * W * H + i) * size, packed + (3 * i + c) * size, size);
+
+    ret = ff_proc_from_frame_to_dnn(frame, &input, cache, NULL);
+    if (ret < 0)
+        goto end;
+
+    ret = memcmp(ref, out, W * H * 3 * size) ? AVERROR_BUG : 0;
+end:
+    av_free(packed);
+    av_free(ref);
+    av_free(out);
+    return ret;
+}
+
+static int test_dnn_to_frame(AVFrame *frame, DNNDataType dt, DNNIOProcCache *cache, AVLFG *lfg)
+{
+    const int size = dt == DNN_FLOAT ? sizeof(float) : 1;
+    uint8_t *planar = av_malloc(W * H * 3 * size);
+    uint8_t *packed = av_malloc(W * H * 3 * size);
+    uint8_t *ref    = av_malloc(W * H * 3);
+    DNNData output = {
+        .data   = planar,
+        .dims   = { 1, 3, H, W },
+        .layout = DL_NCHW,
+        .dt     = dt,
+        .scale  = dt == DNN_FLOAT ? 255 : 1,
+    };
+    int ret;
+
+    if (!planar || !packed || !ref) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    // include values out of [0, 1] and between the 8-bit levels
+    for (int i = 0; i < W * H * 3; i++) {
+        if (dt == DNN_FLOAT)
+            ((float *)planar)[i] = (int)(av_lfg_get(lfg) % 2000) / 1500.0f - 0.2f;
+        else
+            planar[i] = av_lfg_get(lfg);
+    }
+
+    for (int c = 0; c < 3; c++)
+        for (int i = 0; i < W * H; i++)
+            memcpy(packed + (3 * i + c) * size, planar + (c * W * H + i) * size, size);
+    ret = sws_convert(packed, W * 3 * size, dt == DNN_FLOAT ? AV_PIX_FMT_GRAYF32 : AV_PIX_FMT_GRAY8,
+                      ref, W * 3, AV_PIX_FMT_GRAY8);
+    if (ret < 0)
+        goto end;
+
+    ret = ff_proc_from_dnn_to_frame(frame, &output, cache, NULL);
+    if (ret < 0)
+        goto end;
+
+    for (int y = 0; y < H; y++)
+        if (memcmp(ref + y * W * 3, frame->data[0] + y * frame->linesize[0], W * 3))
+            ret = AVERROR_BUG;
+end:
+    av_free(planar);
+    av_free(packed);
+    av_free(ref);
+    return ret;
+}
+
+int main(void)
+{
+    static const enum AVPixelFormat formats[] = { AV_PIX_FMT_RGB24, AV_PIX_FMT_BGR24 };
+    static const DNNDataType types[] = { DNN_FLOAT, DNN_UINT8 };
+    DNNIOProcCache cache = { 0 };
+    AVFrame *frame = av_frame_alloc();
+    AVLFG lfg;
+    int ret = 0;
+
+    if (!frame)
+        return 1;
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    for (int f = 0; f < FF_ARRAY_ELEMS(formats); f++) {
+        frame->format = formats[f];
+        frame->width  = W;
+        frame->height = H;
+        if (av_frame_get_buffer(frame, 0) < 0) {
+            ret = 1;
+            break;
+        }
+
+        for (int t = 0; t < FF_ARRAY_ELEMS(types); t++) {
+            int err;
+
+            for (int y = 0; y < H; y++)
+                for (int x = 0; x < W * 3; x++)
+                    frame->data[0][y * frame->linesize[0] + x] = av_lfg_get(&lfg);
+
+            err = test_frame_to_dnn(frame, types[t], &cache);
+            printf("%s %s frame->dnn: %s\n", av_get_pix_fmt_name(formats[f]),
+                   types[t] == DNN_FLOAT ? "float" : "uint8", err < 0 ? "FAIL" : "OK");
+            ret |= err < 0;
+
+            err = test_dnn_to_frame(frame, types[t], &cache, &lfg);
+            printf("%s %s dnn->frame: %s\n", av_get_pix_fmt_name(formats[f]),
+                   types[t] == DNN_FLOAT ? "float" : "uint8", err < 0 ? "FAIL" : "OK");
+            ret |= err < 0;
+        }
+
+        av_frame_unref(frame);
+    }
+
+    ff_dnn_io_proc_cache_uninit(&cache);
+    av_frame_free(&frame);
+    return ret;
+}
@@ -424,6 +424,11 @@ static av_cold int init(AVFilterContext *ctx)
     // use generic thread-count if the user did not set it explicitly
     if (!scale->sws->threads)
         scale->sws->threads = ff_filter_get_nb_threads(ctx);
+    if (ctx->graph->thread_pool) {
+        scale->sws->thread_pool = av_buffer_ref(ctx->graph->thread_pool);
+        if (!scale->sws->thread_pool)
+            return AVERROR(ENOMEM);
+    }
 
     if (!IS_SCALE2REF(ctx) && scale->uses_ref) {
         AVFilterPad pad = {
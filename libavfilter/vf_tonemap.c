@@ -92,30 +92,53 @@ static float hable(float in)
     return (in * (in * a + b * c) + d * e) / (in * (in * a + b) + d * f) - e / f;
 }
 
-static float mobius(float in, float j, double peak)
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    const AVPixFmtDescriptor *desc;
+    double peak;
+
+    /* per-frame constants, see init_thread_data() */
+    double cr, cg, cb;
+    double gamma_exp, gamma_low;
+    float hable_peak;
+    float mobius_a, mobius_b, mobius_scale;
+} ThreadData;
+
+static void init_thread_data(const TonemapContext *s, ThreadData *td)
 {
-    float a, b;
+    double peak = td->peak;
+    float j = s->param;
+
+    if (s->desat > 0) {
+        td->cr = av_q2d(s->coeffs->cr);
+        td->cg = av_q2d(s->coeffs->cg);
+        td->cb = av_q2d(s->coeffs->cb);
+    }
+
+    td->gamma_exp  = 1.0f / s->param;
+    td->gamma_low  = pow(0.05f / peak, td->gamma_exp);
+    td->hable_peak = hable(peak);
+
+    td->mobius_a = -j * j * (peak - 1.0f) / (j * j - 2.0f * j + peak);
+    td->mobius_b = (j * j - 2.0f * j * peak + peak) / FFMAX(peak - 1.0f, 1e-6);
+    td->mobius_scale = (td->mobius_b * td->mobius_b + 2.0f * td->mobius_b * j + j * j) /
+                       (td->mobius_b - td->mobius_a);
+}
 
+static float mobius(float in, float j, const ThreadData *td)
+{
     if (in <= j)
         return in;
 
-    a = -j * j * (peak - 1.0f) / (j * j - 2.0f * j + peak);
-    b = (j * j - 2.0f * j * peak + peak) / FFMAX(peak - 1.0f, 1e-6);
-
-    return (b * b + 2.0f * b * j + j * j) / (b - a) * (in + a) / (in + b);
+    return td->mobius_scale * (in + td->mobius_a) / (in + td->mobius_b);
 }
 
 #define MIX(x,y,a) (x) * (1 - (a)) + (y) * (a)
-static void tonemap(TonemapContext *s, AVFrame *out, const AVFrame *in,
-                    const AVPixFmtDescriptor *desc, int x, int y, double peak)
+static void tonemap(const TonemapContext *s, const ThreadData *td,
+                    float *r_out, float *g_out, float *b_out,
+                    const float *r_in, const float *g_in, const float *b_in)
 {
-    int map[3] = { desc->comp[0].plane, desc->comp[1].plane, desc->comp[2].plane };
-    const float *r_in = (const float *)(in->data[map[0]] + x * desc->comp[map[0]].step + y * in->linesize[map[0]]);
-    const float *g_in = (const float *)(in->data[map[1]] + x * desc->comp[map[1]].step + y * in->linesize[map[1]]);
-    const float *b_in = (const float *)(in->data[map[2]] + x * desc->comp[map[2]].step + y * in->linesize[map[2]]);
-    float *r_out = (float *)(out->data[map[0]] + x * desc->comp[map[0]].step + y * out->linesize[map[0]]);
-    float *g_out = (float *)(out->data[map[1]] + x * desc->comp[map[1]].step + y * out->linesize[map[1]]);
-    float *b_out = (float *)(out->data[map[2]] + x * desc->comp[map[2]].step + y * out->linesize[map[2]]);
+    double peak = td->peak;
     float sig, sig_orig;
 
     /* load values */
@@ -125,7 +148,7 @@ static void tonemap(TonemapContext *s, AVFrame *out, const AVFrame *in,
 
     /* desaturate to prevent unnatural colors */
     if (s->desat > 0) {
-        float luma = av_q2d(s->coeffs->cr) * *r_in + av_q2d(s->coeffs->cg) * *g_in + av_q2d(s->coeffs->cb) * *b_in;
+        float luma = td->cr * *r_in + td->cg * *g_in + td->cb * *b_in;
         float overbright = FFMAX(luma - s->desat, 1e-6) / FFMAX(luma, 1e-6);
         *r_out = MIX(*r_in, luma, overbright);
         *g_out = MIX(*g_in, luma, overbright);
@@ -147,20 +170,20 @@ static void tonemap(TonemapContext *s, AVFrame *out, const AVFrame *in,
         sig = sig * s->param / peak;
         break;
     case TONEMAP_GAMMA:
-        sig = sig > 0.05f ? pow(sig / peak, 1.0f / s->param)
-                          : sig * pow(0.05f / peak, 1.0f / s->param) / 0.05f;
+        sig = sig > 0.05f ? pow(sig / peak, td->gamma_exp)
+                          : sig * td->gamma_low / 0.05f;
         break;
     case TONEMAP_CLIP:
         sig = av_clipf(sig * s->param, 0, 1.0f);
         break;
     case TONEMAP_HABLE:
-        sig = hable(sig) / hable(peak);
+        sig = hable(sig) / td->hable_peak;
         break;
     case TONEMAP_REINHARD:
         sig = sig / (sig + s->param) * (peak + s->param) / peak;
         break;
     case TONEMAP_MOBIUS:
-        sig = mobius(sig, s->param, peak);
+        sig = mobius(sig, s->param, td);
         break;
     }
 
@@ -171,12 +194,6 @@ static void tonemap(TonemapContext *s, AVFrame *out, const AVFrame *in,
     *b_out *= sig / sig_orig;
 }
 
-typedef struct ThreadData {
-    AVFrame *in, *out;
-    const AVPixFmtDescriptor *desc;
-    double peak;
-} ThreadData;
-
 static int tonemap_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     TonemapContext *s = ctx->priv;
@@ -184,13 +201,22 @@ static int tonemap_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs
     AVFrame *in = td->in;
     AVFrame *out = td->out;
     const AVPixFmtDescriptor *desc = td->desc;
+    const int map[3] = { desc->comp[0].plane, desc->comp[1].plane, desc->comp[2].plane };
     const int slice_start = (in->height * jobnr) / nb_jobs;
     const int slice_end = (in->height * (jobnr+1)) / nb_jobs;
-    double peak = td->peak;
 
-    for (int y = slice_start; y < slice_end; y++)
+    for (int y = slice_start; y < slice_end; y++) {
+        const float *r_in = (const float *)(in->data[map[0]] + y * in->linesize[map[0]]);
+        const float *g_in = (const float *)(in->data[map[1]] + y * in->linesize[map[1]]);
+        const float *b_in = (const float *)(in->data[map[2]] + y * in->linesize[map[2]]);
+        float *r_out = (float *)(out->data[map[0]] + y * out->linesize[map[0]]);
+        float *g_out = (float *)(out->data[map[1]] + y * out->linesize[map[1]]);
+        float *b_out = (float *)(out->data[map[2]] + y * out->linesize[map[2]]);
+
         for (int x = 0; x < out->width; x++)
-            tonemap(s, out, in, desc, x, y, peak);
+            tonemap(s, td, r_out + x, g_out + x, b_out + x,
+                    r_in + x, g_in + x, b_in + x);
+    }
 
     return 0;
 }
@@ -255,6 +281,7 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     td.in = in;
     td.desc = desc;
     td.peak = peak;
+    init_thread_data(s, &td);
     ff_filter_execute(ctx, tonemap_slice, &td, NULL,
                       FFMIN(in->height, ff_filter_get_nb_threads(ctx)));
 
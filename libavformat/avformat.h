@@ -1435,6 +1435,13 @@ typedef struct AVFormatContext {
 #define AVFMT_FLAG_SORT_DTS    0x10000 ///< try to interleave outputted packets by dts (using this flag can slow demuxing down)
 #define AVFMT_FLAG_FAST_SEEK   0x80000 ///< Enable fast, but inaccurate seeks for some formats
 #define AVFMT_FLAG_AUTO_BSF   0x200000 ///< Add bitstream filters as requested by the muxer
+/**
+ * In avformat_find_stream_info(), do not decode streams whose parameters are
+ * fully known from the container, and decode the remaining streams in
+ * parallel. Parameters that only a decoder can provide, such as the audio
+ * sample format, are left unset for the skipped streams.
+ */
+#define AVFMT_FLAG_FAST_STREAM_INFO 0x400000
 
     /**
      * Maximum number of bytes read from input in order to determine stream
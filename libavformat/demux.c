@@ -25,6 +25,7 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
+#include "libavutil/cpu.h"
 #include "libavutil/dict.h"
 #include "libavutil/internal.h"
 #include "libavutil/intreadwrite.h"
@@ -32,6 +33,7 @@
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixfmt.h"
+#include "libavutil/slicethread.h"
 #include "libavutil/time.h"
 #include "libavutil/timestamp.h"
 
@@ -2019,9 +2021,9 @@ static void estimate_timings(AVFormatContext *ic, int64_t old_offset)
            (int64_t)ic->bit_rate / 1000);
 }
 
-static int determinable_frame_size(const AVCodecContext *avctx)
+static int determinable_frame_size(enum AVCodecID codec_id)
 {
-    switch(avctx->codec_id) {
+    switch(codec_id) {
     case AV_CODEC_ID_MP1:
     case AV_CODEC_ID_MP2:
     case AV_CODEC_ID_MP3:
@@ -2048,16 +2050,17 @@ static int has_codec_parameters(const AVStream *st, const char **errmsg_ptr)
         FAIL("unknown codec");
     switch (avctx->codec_type) {
     case AVMEDIA_TYPE_AUDIO:
-        if (!avctx->frame_size && determinable_frame_size(avctx))
+        if (!avctx->frame_size && determinable_frame_size(avctx->codec_id))
             FAIL("unspecified frame size");
-        if (sti->info->found_decoder >= 0 &&
+        if (sti->info->found_decoder >= 0 && !sti->info->skip_decode &&
             avctx->sample_fmt == AV_SAMPLE_FMT_NONE)
             FAIL("unspecified sample format");
         if (!avctx->sample_rate)
             FAIL("unspecified sample rate");
         if (!avctx->ch_layout.nb_channels)
             FAIL("unspecified number of channels");
-        if (sti->info->found_decoder >= 0 && !sti->nb_decoded_frames && avctx->codec_id == AV_CODEC_ID_DTS)
+        if (sti->info->found_decoder >= 0 && !sti->info->skip_decode &&
+            !sti->nb_decoded_frames && avctx->codec_id == AV_CODEC_ID_DTS)
             FAIL("no decodable DTS frames");
         break;
     case AVMEDIA_TYPE_VIDEO:
@@ -2080,20 +2083,56 @@ static int has_codec_parameters(const AVStream *st, const char **errmsg_ptr)
     return 1;
 }
 
+/**
+ * Check whether the container provided everything has_codec_parameters()
+ * looks for, without the help of a decoder. Decoders which can change the
+ * channel configuration are always run, like in try_decode_frame().
+ */
+static int has_container_parameters(const AVStream *st, const AVCodec *codec)
+{
+    const AVCodecParameters *par = st->codecpar;
+
+    if (par->codec_id == AV_CODEC_ID_NONE)
+        return 0;
+
+    switch (par->codec_type) {
+    case AVMEDIA_TYPE_AUDIO:
+        return par->sample_rate > 0 && par->ch_layout.nb_channels > 0 &&
+               par->ch_layout.order != AV_CHANNEL_ORDER_UNSPEC &&
+               !(codec && codec->capabilities & AV_CODEC_CAP_CHANNEL_CONF) &&
+               par->codec_id != AV_CODEC_ID_DTS &&
+               (par->frame_size || !determinable_frame_size(par->codec_id));
+    case AVMEDIA_TYPE_VIDEO:
+        return par->width > 0 && par->height > 0 &&
+               par->format != AV_PIX_FMT_NONE &&
+               par->codec_id != AV_CODEC_ID_RV30 &&
+               par->codec_id != AV_CODEC_ID_RV40;
+    case AVMEDIA_TYPE_SUBTITLE:
+        return par->codec_id != AV_CODEC_ID_HDMV_PGS_SUBTITLE || par->width > 0;
+    }
+
+    return 0;
+}
+
 /* returns 1 or 0 if or if not decoded data was returned, or a negative error */
 static int try_decode_frame(AVFormatContext *s, AVStream *st,
-                            const AVPacket *pkt, AVDictionary **options)
+                            const AVPacket *pkt, AVDictionary **options,
+                            int codec_info_nb_frames)
 {
     FFStream *const sti = ffstream(st);
     AVCodecContext *const avctx = sti->avctx;
     const AVCodec *codec;
     int got_picture = 1, ret = 0;
-    AVFrame *frame = av_frame_alloc();
+    AVFrame *frame;
     AVSubtitle subtitle;
     int do_skip_frame = 0;
     enum AVDiscard skip_frame;
     int pkt_to_send = pkt->size > 0;
 
+    if (sti->info->skip_decode)
+        return 0;
+
+    frame = av_frame_alloc();
     if (!frame)
         return AVERROR(ENOMEM);
 
@@ -2144,7 +2183,7 @@ static int try_decode_frame(AVFormatContext *s, AVStream *st,
     while ((pkt_to_send || (!pkt->data && got_picture)) &&
            ret >= 0 &&
            (!has_codec_parameters(st, NULL) || !has_decode_delay_been_guessed(st) ||
-            (!sti->codec_info_nb_frames &&
+            (!codec_info_nb_frames &&
              (avctx->codec->capabilities & AV_CODEC_CAP_CHANNEL_CONF)))) {
         got_picture = 0;
         if (avctx->codec_type == AVMEDIA_TYPE_VIDEO ||
@@ -2509,9 +2548,122 @@ static int extract_extradata(FFFormatContext *si, AVStream *st, const AVPacket *
     return 0;
 }
 
+#define PARALLEL_PROBE_PACKETS 32
+
+typedef struct ProbePacket {
+    const AVPacket *pkt;
+    int             stream_index;
+    int             codec_info_nb_frames;
+} ProbePacket;
+
+/**
+ * State for decoding the packets read by avformat_find_stream_info() in
+ * parallel. Packets are collected in batches, then each stream with pending
+ * packets becomes one job that decodes them in order.
+ */
+typedef struct ParallelProbe {
+    AVSliceThread   *thread;
+    AVFormatContext *ic;
+    AVDictionary   **options;
+    int              orig_nb_streams;
+
+    ProbePacket      pkts[PARALLEL_PROBE_PACKETS];
+    int              nb_pkts;
+
+    int              streams[PARALLEL_PROBE_PACKETS];
+    int              nb_streams;
+} ParallelProbe;
+
+static void parallel_probe_worker(void *priv, int jobnr, int threadnr,
+                                  int nb_jobs, int nb_threads)
+{
+    ParallelProbe *pp = priv;
+    const int stream_index = pp->streams[jobnr];
+    AVStream *st = pp->ic->streams[stream_index];
+    AVDictionary **opts = pp->options && stream_index < pp->orig_nb_streams ?
+                          &pp->options[stream_index] : NULL;
+
+    for (int i = 0; i < pp->nb_pkts; i++) {
+        const ProbePacket *p = &pp->pkts[i];
+
+        if (p->stream_index == stream_index)
+            try_decode_frame(pp->ic, st, p->pkt, opts, p->codec_info_nb_frames);
+    }
+}
+
+static void parallel_probe_flush(ParallelProbe *pp)
+{
+    pp->nb_streams = 0;
+    for (int i = 0; i < pp->nb_pkts; i++) {
+        int j;
+
+        for (j = 0; j < pp->nb_streams; j++)
+            if (pp->streams[j] == pp->pkts[i].stream_index)
+                break;
+        if (j == pp->nb_streams)
+            pp->streams[pp->nb_streams++] = pp->pkts[i].stream_index;
+    }
+
+    if (pp->nb_streams)
+        avpriv_slicethread_execute(pp->thread, pp->nb_streams, 0);
+
+    pp->nb_pkts = 0;
+}
+
+static int parallel_probe_init(ParallelProbe **ppp, AVFormatContext *ic,
+                               AVDictionary **options, int orig_nb_streams)
+{
+    ParallelProbe *pp;
+    int nb_threads = av_cpu_count();
+    int ret;
+
+    /* new streams may appear later in formats without a header */
+    if (!(ic->ctx_flags & AVFMTCTX_NOHEADER)) {
+        int nb_decode = 0;
+
+        for (unsigned i = 0; i < ic->nb_streams; i++)
+            nb_decode += !ffstream(ic->streams[i])->info->skip_decode;
+        nb_threads = FFMIN(nb_threads, nb_decode);
+    }
+    if (nb_threads < 2)
+        return 0;
+
+    pp = av_mallocz(sizeof(*pp));
+    if (!pp)
+        return AVERROR(ENOMEM);
+
+    ret = avpriv_slicethread_create(&pp->thread, pp, parallel_probe_worker,
+                                    NULL, nb_threads);
+    if (ret < 0) {
+        av_free(pp);
+        /* fall back to decoding on the caller's thread */
+        return ret == AVERROR(ENOSYS) ? 0 : ret;
+    }
+    av_log(ic, AV_LOG_DEBUG, "Probing streams using %d threads\n", ret);
+
+    pp->ic              = ic;
+    pp->options         = options;
+    pp->orig_nb_streams = orig_nb_streams;
+
+    *ppp = pp;
+    return 0;
+}
+
+static void parallel_probe_free(ParallelProbe **ppp)
+{
+    ParallelProbe *pp = *ppp;
+
+    if (!pp)
+        return;
+
+    avpriv_slicethread_free(&pp->thread);
+    av_freep(ppp);
+}
+
 int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
 {
     FFFormatContext *const si = ffformatcontext(ic);
+    ParallelProbe *pp = NULL;
     int count = 0, ret = 0, err;
     int64_t read_size;
     AVPacket *pkt1 = si->pkt;
@@ -2579,6 +2731,10 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
 
         codec = find_probe_decoder(ic, st, st->codecpar->codec_id);
 
+        if ((ic->flags & AVFMT_FLAG_FAST_STREAM_INFO) &&
+            sti->request_probe <= 0 && has_container_parameters(st, codec))
+            sti->info->skip_decode = 1;
+
         /* Force thread count to 1 since the H.264 decoder will not extract
          * SPS and PPS to extradata during multi-threaded decoding. */
         av_dict_set(options ? &options[i] : &thread_opt, "threads", "1", 0);
@@ -2603,6 +2759,14 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
             av_dict_free(&thread_opt);
     }
 
+    /* decoding in batches needs the packets to stay around */
+    if ((ic->flags & AVFMT_FLAG_FAST_STREAM_INFO) &&
+        !(ic->flags & AVFMT_FLAG_NOBUFFER)) {
+        ret = parallel_probe_init(&pp, ic, options, orig_nb_streams);
+        if (ret < 0)
+            goto find_stream_info_err;
+    }
+
     read_size = 0;
     for (;;) {
         const AVPacket *pkt;
@@ -2727,6 +2891,11 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
             if (ret < 0)
                 goto unref_then_goto_end;
             sti->avctx_inited = 1;
+
+            if ((ic->flags & AVFMT_FLAG_FAST_STREAM_INFO) &&
+                has_container_parameters(st, find_probe_decoder(ic, st,
+                                                                st->codecpar->codec_id)))
+                sti->info->skip_decode = 1;
         }
 
         if (pkt->dts != AV_NOPTS_VALUE && sti->codec_info_nb_frames > 1) {
@@ -2831,8 +3000,20 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
          * least one frame of codec data, this makes sure the codec initializes
          * the channel configuration and does not only trust the values from
          * the container. */
-        try_decode_frame(ic, st, pkt,
-                         (options && i < orig_nb_streams) ? &options[i] : NULL);
+        if (pp && !sti->info->skip_decode) {
+            ProbePacket *p = &pp->pkts[pp->nb_pkts++];
+
+            p->pkt                  = pkt;
+            p->stream_index         = pkt->stream_index;
+            p->codec_info_nb_frames = sti->codec_info_nb_frames;
+
+            if (pp->nb_pkts == PARALLEL_PROBE_PACKETS)
+                parallel_probe_flush(pp);
+        } else {
+            try_decode_frame(ic, st, pkt,
+                             (options && i < orig_nb_streams) ? &options[i] : NULL,
+                             sti->codec_info_nb_frames);
+        }
 
         if (ic->flags & AVFMT_FLAG_NOBUFFER)
             av_packet_unref(pkt1);
@@ -2841,6 +3022,9 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
         count++;
     }
 
+    if (pp)
+        parallel_probe_flush(pp);
+
     if (eof_reached) {
         for (unsigned stream_index = 0; stream_index < ic->nb_streams; stream_index++) {
             AVStream *const st = ic->streams[stream_index];
@@ -2879,7 +3063,8 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
             if (sti->info->found_decoder == 1) {
                 err = try_decode_frame(ic, st, empty_pkt,
                                         (options && i < orig_nb_streams)
-                                        ? &options[i] : NULL);
+                                        ? &options[i] : NULL,
+                                        sti->codec_info_nb_frames);
 
                 if (err < 0) {
                     av_log(ic, AV_LOG_INFO,
@@ -3062,6 +3247,8 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
     }
 
 find_stream_info_err:
+    parallel_probe_free(&pp);
+
     for (unsigned i = 0; i < ic->nb_streams; i++) {
         AVStream *const st  = ic->streams[i];
         FFStream *const sti = ffstream(st);
@@ -158,6 +158,12 @@ typedef struct FFStreamInfo {
      */
     int found_decoder;
 
+    /**
+     * Set with AVFMT_FLAG_FAST_STREAM_INFO when the container provided all
+     * the parameters, the stream is then not decoded.
+     */
+    int skip_decode;
+
     int64_t last_duration;
 
     /**
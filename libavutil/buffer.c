@@ -26,12 +26,13 @@
 #include "mem.h"
 #include "thread.h"
 
-static AVBufferRef *buffer_create(AVBuffer *buf, uint8_t *data, size_t size,
+static void pool_release_buffer(void *opaque, uint8_t *data);
+
+static AVBufferRef *buffer_create(AVBuffer *buf, AVBufferRef *ref,
+                                  uint8_t *data, size_t size,
                                   void (*free)(void *opaque, uint8_t *data),
                                   void *opaque, int flags)
 {
-    AVBufferRef *ref = NULL;
-
     buf->data     = data;
     buf->size     = size;
     buf->free     = free ? free : av_buffer_default_free;
@@ -41,7 +42,8 @@ static AVBufferRef *buffer_create(AVBuffer *buf, uint8_t *data, size_t size,
 
     buf->flags = flags;
 
-    ref = av_mallocz(sizeof(*ref));
+    if (!ref)
+        ref = av_mallocz(sizeof(*ref));
     if (!ref)
         return NULL;
 
@@ -61,7 +63,7 @@ AVBufferRef *av_buffer_create(uint8_t *data, size_t size,
     if (!buf)
         return NULL;
 
-    ret = buffer_create(buf, data, size, free, opaque, flags);
+    ret = buffer_create(buf, NULL, data, size, free, opaque, flags);
     if (!ret) {
         av_free(buf);
         return NULL;
@@ -114,13 +116,28 @@ AVBufferRef *av_buffer_ref(const AVBufferRef *buf)
     return ret;
 }
 
+/* whether ref is the one embedded in the pool entry of its buffer */
+static int buffer_ref_is_embedded(const AVBufferRef *ref)
+{
+    const AVBuffer *b = ref->buffer;
+
+    return b->free == pool_release_buffer &&
+           ref == &((BufferPoolEntry *)b->opaque)->ref;
+}
+
 static void buffer_replace(AVBufferRef **dst, AVBufferRef **src)
 {
     AVBuffer *b;
 
     b = (*dst)->buffer;
 
-    if (src) {
+    /* an embedded ref is reused by the pool once the buffer is returned to
+     * it, so it must not be freed or keep referencing anything */
+    if (buffer_ref_is_embedded(*dst)) {
+        *dst = src ? *src : NULL;
+        if (src)
+            *src = NULL;
+    } else if (src) {
         **dst = **src;
         av_freep(src);
     } else
@@ -396,7 +413,8 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
     buf = pool->pool;
     if (buf) {
         memset(&buf->buffer, 0, sizeof(buf->buffer));
-        ret = buffer_create(&buf->buffer, buf->data, pool->size,
+        memset(&buf->ref,    0, sizeof(buf->ref));
+        ret = buffer_create(&buf->buffer, &buf->ref, buf->data, pool->size,
                             pool_release_buffer, buf, 0);
         if (ret) {
             pool->pool = buf->next;
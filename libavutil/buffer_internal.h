@@ -83,6 +83,12 @@ typedef struct BufferPoolEntry {
      * of this BufferPoolEntry.
      */
     AVBuffer buffer;
+
+    /*
+     * The AVBufferRef returned by av_buffer_pool_get() when this entry is
+     * reused, so that getting a buffer from the pool does not allocate.
+     */
+    AVBufferRef ref;
 } BufferPoolEntry;
 
 struct AVBufferPool {
@@ -315,15 +315,18 @@ static const AVCRC av_crc_table[AV_CRC_MAX][257] = {
 #if CONFIG_SMALL
 #define CRC_TABLE_SIZE 257
 #else
-#define CRC_TABLE_SIZE 1024
+/* The built-in tables carry 8 slices, see av_crc(). */
+#define CRC_TABLE_SIZE 2048
 #endif
 static AVCRC av_crc_table[AV_CRC_MAX][CRC_TABLE_SIZE];
 
-#define DECLARE_CRC_INIT_TABLE_ONCE(id, le, bits, poly)                                       \
-static AVOnce id ## _once_control = AV_ONCE_INIT;                                             \
-static void id ## _init_table_once(void)                                                      \
-{                                                                                             \
-    av_assert0(av_crc_init(av_crc_table[id], le, bits, poly, sizeof(av_crc_table[id])) >= 0); \
+static int crc_init(AVCRC *ctx, int le, int bits, uint32_t poly, int ctx_size);
+
+#define DECLARE_CRC_INIT_TABLE_ONCE(id, le, bits, poly)                                    \
+static AVOnce id ## _once_control = AV_ONCE_INIT;                                          \
+static void id ## _init_table_once(void)                                                   \
+{                                                                                          \
+    av_assert0(crc_init(av_crc_table[id], le, bits, poly, sizeof(av_crc_table[id])) >= 0); \
 }
 
 #define CRC_INIT_TABLE_ONCE(id) ff_thread_once(&id ## _once_control, id ## _init_table_once)
@@ -338,15 +341,13 @@ DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_32_IEEE_LE, 1, 32, 0xEDB88320)
 DECLARE_CRC_INIT_TABLE_ONCE(AV_CRC_16_ANSI_LE, 1, 16,     0xA001)
 #endif
 
-int av_crc_init(AVCRC *ctx, int le, int bits, uint32_t poly, int ctx_size)
+static int crc_init(AVCRC *ctx, int le, int bits, uint32_t poly, int ctx_size)
 {
     unsigned i, j;
     uint32_t c;
 
     if (bits < 8 || bits > 32 || poly >= (1LL << bits))
         return AVERROR(EINVAL);
-    if (ctx_size != sizeof(AVCRC) * 257 && ctx_size != sizeof(AVCRC) * 1024)
-        return AVERROR(EINVAL);
 
     for (i = 0; i < 256; i++) {
         if (le) {
@@ -361,16 +362,23 @@ int av_crc_init(AVCRC *ctx, int le, int bits, uint32_t poly, int ctx_size)
     }
     ctx[256] = 1;
 #if !CONFIG_SMALL
-    if (ctx_size >= sizeof(AVCRC) * 1024)
-        for (i = 0; i < 256; i++)
-            for (j = 0; j < 3; j++)
-                ctx[256 * (j + 1) + i] =
-                    (ctx[256 * j + i] >> 8) ^ ctx[ctx[256 * j + i] & 0xFF];
+    for (i = 0; i < 256; i++)
+        for (j = 0; j + 1 < ctx_size / (256 * sizeof(AVCRC)); j++)
+            ctx[256 * (j + 1) + i] =
+                (ctx[256 * j + i] >> 8) ^ ctx[ctx[256 * j + i] & 0xFF];
 #endif
 
     return 0;
 }
 
+int av_crc_init(AVCRC *ctx, int le, int bits, uint32_t poly, int ctx_size)
+{
+    if (ctx_size != sizeof(AVCRC) * 257 && ctx_size != sizeof(AVCRC) * 1024)
+        return AVERROR(EINVAL);
+
+    return crc_init(ctx, le, bits, poly, ctx_size);
+}
+
 const AVCRC *av_crc_get_table(AVCRCId crc_id)
 {
 #if !CONFIG_HARDCODED_TABLES
@@ -399,6 +407,25 @@ uint32_t av_crc(const AVCRC *ctx, uint32_t crc,
         while (((intptr_t) buffer & 3) && buffer < end)
             crc = ctx[((uint8_t) crc) ^ *buffer++] ^ (crc >> 8);
 
+#if !CONFIG_HARDCODED_TABLES
+        /* Only the built-in tables are known to have 8 slices. */
+        if ((uintptr_t) ctx - (uintptr_t) av_crc_table < sizeof(av_crc_table)) {
+            while (buffer < end - 7) {
+                uint32_t a = crc ^ av_le2ne32(((const uint32_t *) buffer)[0]);
+                uint32_t b =       av_le2ne32(((const uint32_t *) buffer)[1]);
+                buffer += 8;
+                crc = ctx[7 * 256 + ( a        & 0xFF)] ^
+                      ctx[6 * 256 + ((a >> 8 ) & 0xFF)] ^
+                      ctx[5 * 256 + ((a >> 16) & 0xFF)] ^
+                      ctx[4 * 256 + ((a >> 24)       )] ^
+                      ctx[3 * 256 + ( b        & 0xFF)] ^
+                      ctx[2 * 256 + ((b >> 8 ) & 0xFF)] ^
+                      ctx[1 * 256 + ((b >> 16) & 0xFF)] ^
+                      ctx[0 * 256 + ((b >> 24)       )];
+            }
+        }
+#endif
+
         while (buffer < end - 3) {
             crc ^= av_le2ne32(*(const uint32_t *) buffer); buffer += 4;
             crc = ctx[3 * 256 + ( crc        & 0xFF)] ^
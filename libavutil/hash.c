@@ -21,7 +21,6 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
-#include <stdio.h>
 #include <string.h>
 #include "hash.h"
 
@@ -224,12 +223,17 @@ void av_hash_final_bin(struct AVHashContext *ctx, uint8_t *dst, int size)
 
 void av_hash_final_hex(struct AVHashContext *ctx, uint8_t *dst, int size)
 {
+    static const char hex[] = "0123456789abcdef";
     uint8_t buf[AV_HASH_MAX_SIZE];
     unsigned rsize = av_hash_get_size(ctx), i;
 
     av_hash_final(ctx, buf);
-    for (i = 0; i < FFMIN(rsize, size / 2); i++)
-        snprintf(dst + i * 2, size - i * 2, "%02x", buf[i]);
+    for (i = 0; i < FFMIN(rsize, size / 2); i++) {
+        dst[i * 2    ] = hex[buf[i] >> 4];
+        dst[i * 2 + 1] = hex[buf[i] & 15];
+    }
+    if (size > 0)
+        dst[FFMIN(rsize * 2, size - 1)] = 0;
 }
 
 void av_hash_final_b64(struct AVHashContext *ctx, uint8_t *dst, int size)
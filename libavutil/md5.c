@@ -187,12 +187,11 @@ void av_md5_update(AVMD5 *ctx, const uint8_t *src, size_t len)
 
 void av_md5_final(AVMD5 *ctx, uint8_t *dst)
 {
+    static const uint8_t pad[64] = { 0x80 };
     int i;
     uint64_t finalcount = av_le2ne64(ctx->len << 3);
 
-    av_md5_update(ctx, "\200", 1);
-    while ((ctx->len & 63) != 56)
-        av_md5_update(ctx, "", 1);
+    av_md5_update(ctx, pad, 1 + ((55 - ctx->len) & 63));
 
     av_md5_update(ctx, (uint8_t *) &finalcount, 8);
 
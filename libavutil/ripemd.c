@@ -547,12 +547,11 @@ void av_ripemd_update(AVRIPEMD* ctx, const uint8_t* data, size_t len)
 
 void av_ripemd_final(AVRIPEMD* ctx, uint8_t *digest)
 {
+    static const uint8_t pad[64] = { 0x80 };
     int i;
     uint64_t finalcount = av_le2ne64(ctx->count << 3);
 
-    av_ripemd_update(ctx, "\200", 1);
-    while ((ctx->count & 63) != 56)
-        av_ripemd_update(ctx, "", 1);
+    av_ripemd_update(ctx, pad, 1 + ((55 - ctx->count) & 63));
     av_ripemd_update(ctx, (uint8_t *)&finalcount, 8); /* Should cause a transform() */
     for (i = 0; i < ctx->digest_len; i++)
         AV_WL32(digest + i*4, ctx->state[i]);
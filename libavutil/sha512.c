@@ -274,13 +274,12 @@ void av_sha512_update(AVSHA512* ctx, const uint8_t* data, size_t len)
 
 void av_sha512_final(AVSHA512* ctx, uint8_t *digest)
 {
-    uint64_t i = 0;
+    static const uint8_t pad[128 + 8] = { 0x80 };
+    uint64_t i;
     uint64_t finalcount = av_be2ne64(ctx->count << 3);
 
-    av_sha512_update(ctx, "\200", 1);
-    while ((ctx->count & 127) != 112)
-        av_sha512_update(ctx, "", 1);
-    av_sha512_update(ctx, (uint8_t *)&i, 8);
+    /* Padding followed by the upper 64 bits of the 128-bit length. */
+    av_sha512_update(ctx, pad, 1 + ((111 - ctx->count) & 127) + 8);
     av_sha512_update(ctx, (uint8_t *)&finalcount, 8); /* Should cause a transform() */
     for (i = 0; i < ctx->digest_len; i++)
         AV_WB64(digest + i*8, ctx->state[i]);
@@ -17,11 +17,13 @@
  */
 
 #include <stdatomic.h>
+#include "buffer.h"
 #include "cpu.h"
 #include "internal.h"
 #include "slicethread.h"
 #include "mem.h"
 #include "thread.h"
+#include "threadpool.h"
 #include "avassert.h"
 
 #define MAX_AUTO_THREADS 16
@@ -52,6 +54,25 @@ struct AVSliceThread {
     void            *priv;
     void            (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads);
     void            (*main_func)(void *priv);
+
+    /* only used for contexts running on a shared AVThreadPool,
+     * nb_joined, nb_left and next are protected by the pool mutex */
+    AVBufferRef     *pool_ref;
+    AVThreadPool    *pool;
+    AVSliceThread   *next;
+    int             nb_joined;
+    int             nb_left;
+};
+
+struct AVThreadPool {
+    pthread_t       *threads;
+    int             nb_threads;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    /* executions which still accept helper threads, oldest first */
+    AVSliceThread   *queue;
+    int             finished;
 };
 
 static int run_jobs(AVSliceThread *ctx)
@@ -95,6 +116,206 @@ static void *attribute_align_arg thread_worker(void *v)
     }
 }
 
+static void run_shared_jobs(AVSliceThread *ctx, int threadnr)
+{
+    unsigned nb_jobs = ctx->nb_jobs;
+    unsigned job;
+
+    while ((job = atomic_fetch_add_explicit(&ctx->current_job, 1, memory_order_acq_rel)) < nb_jobs)
+        ctx->worker_func(ctx->priv, job, threadnr, nb_jobs, ctx->nb_active_threads);
+}
+
+static void pool_unlink(AVThreadPool *pool, AVSliceThread *ctx)
+{
+    AVSliceThread **p = &pool->queue;
+
+    while (*p && *p != ctx)
+        p = &(*p)->next;
+    if (*p)
+        *p = ctx->next;
+}
+
+static void *attribute_align_arg pool_worker(void *v)
+{
+    AVThreadPool *pool = v;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (!pool->finished) {
+        AVSliceThread *ctx = pool->queue;
+        int threadnr;
+
+        if (!ctx) {
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+            continue;
+        }
+
+        threadnr = ctx->nb_joined++;
+        if (ctx->nb_joined == ctx->nb_active_threads ||
+            atomic_load_explicit(&ctx->current_job, memory_order_relaxed) >= ctx->nb_jobs)
+            pool->queue = ctx->next;
+        pthread_mutex_unlock(&pool->mutex);
+
+        run_shared_jobs(ctx, threadnr);
+
+        /* ctx may be freed as soon as the mutex is released */
+        pthread_mutex_lock(&pool->mutex);
+        ctx->nb_left++;
+        pthread_cond_signal(&ctx->done_cond);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+static void pool_free(void *opaque, uint8_t *data)
+{
+    AVThreadPool *pool = (AVThreadPool *)data;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->finished = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->nb_threads; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->mutex);
+    av_freep(&pool->threads);
+    av_free(pool);
+}
+
+av_cold int av_thread_pool_create(AVBufferRef **pool_ref, int nb_threads)
+{
+    AVThreadPool *pool;
+    AVBufferRef *buf;
+    int ret;
+
+    *pool_ref = NULL;
+    if (nb_threads < 0)
+        return AVERROR(EINVAL);
+    if (!nb_threads)
+        nb_threads = av_cpu_count();
+
+    pool = av_mallocz(sizeof(*pool));
+    if (!pool)
+        return AVERROR(ENOMEM);
+
+    pool->threads = av_calloc(nb_threads, sizeof(*pool->threads));
+    if (!pool->threads) {
+        av_free(pool);
+        return AVERROR(ENOMEM);
+    }
+
+    ret = pthread_mutex_init(&pool->mutex, NULL);
+    if (ret) {
+        av_freep(&pool->threads);
+        av_free(pool);
+        return AVERROR(ret);
+    }
+    ret = pthread_cond_init(&pool->cond, NULL);
+    if (ret) {
+        pthread_mutex_destroy(&pool->mutex);
+        av_freep(&pool->threads);
+        av_free(pool);
+        return AVERROR(ret);
+    }
+
+    /* pool_free() joins only the threads started so far */
+    buf = av_buffer_create((uint8_t *)pool, sizeof(*pool), pool_free, NULL, 0);
+    if (!buf) {
+        pool_free(NULL, (uint8_t *)pool);
+        return AVERROR(ENOMEM);
+    }
+
+    for (int i = 0; i < nb_threads; i++) {
+        ret = pthread_create(&pool->threads[i], NULL, pool_worker, pool);
+        if (ret) {
+            av_buffer_unref(&buf);
+            return AVERROR(ret);
+        }
+        pool->nb_threads++;
+    }
+
+    *pool_ref = buf;
+    return 0;
+}
+
+av_cold
+int avpriv_slicethread_create_shared(AVSliceThread **pctx, AVBufferRef *pool_ref, void *priv,
+                                     void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                     int nb_threads)
+{
+    AVThreadPool *pool = (AVThreadPool *)pool_ref->data;
+    AVSliceThread *ctx;
+    int ret;
+
+    av_assert0(nb_threads >= 0);
+    /* the calling thread takes part in every execution */
+    if (!nb_threads || nb_threads > pool->nb_threads + 1)
+        nb_threads = pool->nb_threads + 1;
+
+    *pctx = ctx = av_mallocz(sizeof(*ctx));
+    if (!ctx)
+        return AVERROR(ENOMEM);
+
+    ctx->pool_ref = av_buffer_ref(pool_ref);
+    if (!ctx->pool_ref) {
+        av_freep(pctx);
+        return AVERROR(ENOMEM);
+    }
+    ctx->pool        = pool;
+    ctx->priv        = priv;
+    ctx->worker_func = worker_func;
+    ctx->nb_threads  = nb_threads;
+    atomic_init(&ctx->first_job, 0);
+    atomic_init(&ctx->current_job, 0);
+
+    ret = pthread_cond_init(&ctx->done_cond, NULL);
+    if (ret) {
+        av_buffer_unref(&ctx->pool_ref);
+        av_freep(pctx);
+        return AVERROR(ret);
+    }
+
+    return nb_threads;
+}
+
+static void execute_shared(AVSliceThread *ctx, int nb_jobs)
+{
+    AVThreadPool *pool = ctx->pool;
+    int nb_active_threads = FFMIN(nb_jobs, ctx->nb_threads);
+
+    ctx->nb_jobs           = nb_jobs;
+    ctx->nb_active_threads = nb_active_threads;
+    atomic_store_explicit(&ctx->current_job, 0, memory_order_relaxed);
+
+    if (nb_active_threads > 1) {
+        AVSliceThread **p = &pool->queue;
+
+        pthread_mutex_lock(&pool->mutex);
+        ctx->nb_joined = 1;
+        ctx->nb_left   = 0;
+        ctx->next      = NULL;
+        while (*p)
+            p = &(*p)->next;
+        *p = ctx;
+        for (int i = 1; i < nb_active_threads; i++)
+            pthread_cond_signal(&pool->cond);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    run_shared_jobs(ctx, 0);
+
+    if (nb_active_threads > 1) {
+        pthread_mutex_lock(&pool->mutex);
+        pool_unlink(pool, ctx);
+        while (ctx->nb_left < ctx->nb_joined - 1)
+            pthread_cond_wait(&ctx->done_cond, &pool->mutex);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
 av_cold
 int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
                               void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
@@ -193,6 +414,11 @@ void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_mai
     int nb_workers, i, is_last = 0;
 
     av_assert0(nb_jobs > 0);
+    if (ctx->pool) {
+        execute_shared(ctx, nb_jobs);
+        return;
+    }
+
     ctx->nb_jobs           = nb_jobs;
     ctx->nb_active_threads = FFMIN(nb_jobs, ctx->nb_threads);
     atomic_store_explicit(&ctx->first_job, 0, memory_order_relaxed);
@@ -231,6 +457,13 @@ av_cold void avpriv_slicethread_free(AVSliceThread **pctx)
     if (!ctx)
         return;
 
+    if (ctx->pool) {
+        pthread_cond_destroy(&ctx->done_cond);
+        av_buffer_unref(&ctx->pool_ref);
+        av_freep(pctx);
+        return;
+    }
+
     nb_workers = ctx->nb_threads;
     if (!ctx->main_func)
         nb_workers--;
@@ -268,6 +501,20 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
     return AVERROR(ENOSYS);
 }
 
+int av_thread_pool_create(AVBufferRef **pool_ref, int nb_threads)
+{
+    *pool_ref = NULL;
+    return AVERROR(ENOSYS);
+}
+
+int avpriv_slicethread_create_shared(AVSliceThread **pctx, AVBufferRef *pool_ref, void *priv,
+                                     void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                     int nb_threads)
+{
+    *pctx = NULL;
+    return AVERROR(ENOSYS);
+}
+
 void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_main)
 {
     av_assert0(0);
@@ -19,6 +19,8 @@
 #ifndef AVUTIL_SLICETHREAD_H
 #define AVUTIL_SLICETHREAD_H
 
+#include "buffer.h"
+
 typedef struct AVSliceThread AVSliceThread;
 
 /**
@@ -35,6 +37,22 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
                               void (*main_func)(void *priv),
                               int nb_threads);
 
+/**
+ * Create slice threading context running on a shared thread pool instead of
+ * its own threads. Executions from several contexts may share the pool
+ * concurrently; the calling thread always takes part in its own execution.
+ * @param pctx slice threading context returned here
+ * @param pool_ref reference to an AVThreadPool, see av_thread_pool_create()
+ * @param priv private pointer to be passed to callback function
+ * @param worker_func callback function to be executed
+ * @param nb_threads maximum number of threads per execution, 0 for all
+ *                   threads of the pool plus the calling thread
+ * @return return number of threads or negative AVERROR on failure
+ */
+int avpriv_slicethread_create_shared(AVSliceThread **pctx, AVBufferRef *pool_ref, void *priv,
+                                     void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                     int nb_threads);
+
 /**
  * Execute slice threading.
  * @param ctx slice threading context
@@ -0,0 +1,96 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/mem.h"
+
+#define NB_BUFFERS 4
+#define BUF_SIZE   1024
+
+int main(void)
+{
+    AVBufferPool *pool;
+    AVBufferRef *refs[NB_BUFFERS];
+    AVBufferRef *ref, *ref2;
+    int ret = 0;
+
+    pool = av_buffer_pool_init(BUF_SIZE, NULL);
+    if (!pool)
+        return 1;
+
+    /* warm up the pool */
+    for (int i = 0; i < NB_BUFFERS; i++) {
+        refs[i] = av_buffer_pool_get(pool);
+        if (!refs[i])
+            return 1;
+    }
+    for (int i = 0; i < NB_BUFFERS; i++)
+        av_buffer_unref(&refs[i]);
+
+    /* once warmed up, getting and releasing buffers must not allocate */
+    av_max_alloc(0);
+    for (int iter = 0; iter < 1000 && !ret; iter++) {
+        for (int i = 0; i < NB_BUFFERS; i++) {
+            refs[i] = av_buffer_pool_get(pool);
+            if (!refs[i] || refs[i]->size != BUF_SIZE) {
+                ret = 1;
+                break;
+            }
+            memset(refs[i]->data, i, BUF_SIZE);
+        }
+        for (int i = 0; i < NB_BUFFERS; i++)
+            av_buffer_unref(&refs[i]);
+    }
+    av_max_alloc(INT_MAX);
+    printf("steady state allocation-free: %s\n", ret ? "no" : "yes");
+
+    /* a reused buffer's ref must stay valid when it is replaced or outlived
+     * by other references */
+    ref  = av_buffer_pool_get(pool);
+    ref2 = ref ? av_buffer_ref(ref) : NULL;
+    if (!ref2)
+        return 1;
+    memset(ref->data, 0x5a, BUF_SIZE);
+    if (av_buffer_make_writable(&ref) < 0)
+        return 1;
+    av_buffer_unref(&ref2);
+    printf("make_writable copy: %s\n",
+           ref->data[0] == 0x5a && ref->data[BUF_SIZE - 1] == 0x5a ? "ok" : "fail");
+    av_buffer_unref(&ref);
+
+    ref  = av_buffer_pool_get(pool);
+    ref2 = ref ? av_buffer_ref(ref) : NULL;
+    if (!ref2)
+        return 1;
+    av_buffer_unref(&ref);
+    memset(ref2->data, 0xa5, BUF_SIZE);
+    ref = av_buffer_pool_get(pool);
+    printf("outlived ref: %s\n",
+           ref && ref->data != ref2->data && ref2->data[0] == 0xa5 &&
+           av_buffer_get_ref_count(ref2) == 1 ? "ok" : "fail");
+    av_buffer_unref(&ref);
+    av_buffer_unref(&ref2);
+
+    av_buffer_pool_uninit(&pool);
+
+    return ret;
+}
@@ -0,0 +1,66 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * @ingroup lavu_threadpool
+ * Public header for the shared thread pool.
+ */
+
+#ifndef AVUTIL_THREADPOOL_H
+#define AVUTIL_THREADPOOL_H
+
+#include "buffer.h"
+
+/**
+ * @defgroup lavu_threadpool Shared thread pool
+ * @ingroup lavu_misc
+ *
+ * A pool of worker threads that can be shared by several codec, filtergraph
+ * and scaling contexts, so that their slice threading does not need one set
+ * of threads per context. A pool is attached to a context by setting e.g.
+ * AVCodecContext.thread_pool, AVFilterGraph.thread_pool or
+ * SwsContext.thread_pool to a new reference to it.
+ *
+ * The pool is reference counted through AVBufferRef; its threads are stopped
+ * once the last reference to it is released.
+ *
+ * @{
+ */
+
+/**
+ * Opaque shared thread pool, stored in AVBufferRef.data.
+ */
+typedef struct AVThreadPool AVThreadPool;
+
+/**
+ * Create a thread pool and start its threads.
+ *
+ * @param pool_ref  a reference to the newly created pool is written here,
+ *                  to be freed with av_buffer_unref()
+ * @param nb_threads number of worker threads, 0 for one per logical CPU
+ * @return 0 on success, AVERROR(ENOSYS) if FFmpeg was built without thread
+ *         support, or another negative error code on failure
+ */
+int av_thread_pool_create(AVBufferRef **pool_ref, int nb_threads);
+
+/**
+ * @}
+ */
+
+#endif /* AVUTIL_THREADPOOL_H */
@@ -0,0 +1,239 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "avutil.h"
+#include "error.h"
+#include "trace.h"
+#include "trace_internal.h"
+
+#if CONFIG_TRACE_EVENTS
+#include <pthread.h>
+
+#include "file_open.h"
+#include "mem.h"
+#include "thread.h"
+#include "time.h"
+
+#define TRACE_BUFFER_SIZE (1 << 14)
+
+typedef struct TraceEvent {
+    const char *name;
+    int64_t     ts;
+    int64_t     pts;
+    char        phase;
+} TraceEvent;
+
+/* Events of one thread. Only the owning thread writes to it, once the
+ * buffer is full its oldest events are overwritten. */
+typedef struct TraceBuffer {
+    TraceEvent events[TRACE_BUFFER_SIZE];
+    /* number of events recorded so far, stored after the event is written */
+    atomic_uint_least64_t count;
+    int tid;
+    /* whether a live thread owns the buffer, protected by trace_lock */
+    int in_use;
+    struct TraceBuffer *next;
+} TraceBuffer;
+
+static AVOnce        trace_init_once = AV_ONCE_INIT;
+static pthread_key_t trace_key;
+static int           trace_key_ok;
+
+/* all buffers, they are kept after their thread exits so that its events
+ * can still be exported, and handed over to the next thread that starts
+ * recording, so there are never more buffers than concurrent threads */
+static AVMutex      trace_lock = AV_MUTEX_INITIALIZER;
+static TraceBuffer *trace_buffers;
+static int          trace_nb_buffers;
+
+static void trace_buffer_release(void *arg)
+{
+    TraceBuffer *buf = arg;
+
+    ff_mutex_lock(&trace_lock);
+    buf->in_use = 0;
+    ff_mutex_unlock(&trace_lock);
+}
+
+static void trace_init(void)
+{
+    trace_key_ok = !pthread_key_create(&trace_key, trace_buffer_release);
+}
+
+static TraceBuffer *trace_buffer_get(void)
+{
+    TraceBuffer *buf;
+
+    ff_thread_once(&trace_init_once, trace_init);
+    if (!trace_key_ok)
+        return NULL;
+
+    buf = pthread_getspecific(trace_key);
+    if (buf)
+        return buf;
+
+    ff_mutex_lock(&trace_lock);
+
+    /* reuse the buffer of a thread that exited, it keeps recording into the
+     * same ring and under the same tid */
+    for (buf = trace_buffers; buf && buf->in_use; buf = buf->next)
+        ;
+
+    if (!buf) {
+        buf = av_mallocz(sizeof(*buf));
+        if (!buf)
+            goto end;
+
+        buf->tid      = ++trace_nb_buffers;
+        buf->next     = trace_buffers;
+        trace_buffers = buf;
+    }
+
+    if (pthread_setspecific(trace_key, buf))
+        buf = NULL;
+    else
+        buf->in_use = 1;
+
+end:
+    ff_mutex_unlock(&trace_lock);
+
+    return buf;
+}
+
+void avpriv_trace_event(const char *name, char phase, int64_t pts)
+{
+    TraceBuffer *buf = trace_buffer_get();
+    TraceEvent *ev;
+    uint64_t idx;
+
+    if (!buf)
+        return;
+
+    idx = atomic_load_explicit(&buf->count, memory_order_relaxed);
+    ev  = &buf->events[idx & (TRACE_BUFFER_SIZE - 1)];
+
+    /* pairs with the fence in trace_buffer_snapshot(): a reader that sees
+     * any part of this event also sees the count stored before it */
+    atomic_thread_fence(memory_order_release);
+
+    ev->name  = name;
+    ev->ts    = av_gettime_relative();
+    ev->pts   = pts;
+    ev->phase = phase;
+
+    atomic_store_explicit(&buf->count, idx + 1, memory_order_release);
+}
+
+/* Copy the events of buf that are not overwritten while copying them,
+ * the owning thread may still be recording. */
+static size_t trace_buffer_snapshot(const TraceBuffer *buf, TraceEvent *events)
+{
+    uint64_t end   = atomic_load_explicit(&buf->count, memory_order_acquire);
+    uint64_t start = end > TRACE_BUFFER_SIZE ? end - TRACE_BUFFER_SIZE : 0;
+    uint64_t end2;
+
+    for (uint64_t i = start; i < end; i++)
+        events[i - start] = buf->events[i & (TRACE_BUFFER_SIZE - 1)];
+
+    atomic_thread_fence(memory_order_acquire);
+    end2 = atomic_load_explicit(&buf->count, memory_order_relaxed);
+
+    /* the event being written at index end2 replaces the one at
+     * end2 - TRACE_BUFFER_SIZE, so that one is not valid either */
+    if (end2 + 1 > start + TRACE_BUFFER_SIZE) {
+        uint64_t skip = FFMIN(end2 + 1 - TRACE_BUFFER_SIZE, end) - start;
+        memmove(events, events + skip, (end - start - skip) * sizeof(*events));
+        return end - start - skip;
+    }
+
+    return end - start;
+}
+
+int av_trace_write_json(const char *filename)
+{
+    TraceEvent *events;
+    TraceBuffer *buf;
+    FILE *f;
+    int ret, first = 1;
+
+    events = av_malloc_array(TRACE_BUFFER_SIZE, sizeof(*events));
+    if (!events)
+        return AVERROR(ENOMEM);
+
+    f = avpriv_fopen_utf8(filename, "w");
+    if (!f) {
+        ret = AVERROR(errno);
+        av_free(events);
+        return ret;
+    }
+
+    /* new threads wait for the export before they can start recording */
+    ff_mutex_lock(&trace_lock);
+
+    fprintf(f, "{\"traceEvents\":[\n");
+    for (buf = trace_buffers; buf; buf = buf->next) {
+        size_t nb_events = trace_buffer_snapshot(buf, events);
+
+        for (size_t i = 0; i < nb_events; i++) {
+            const TraceEvent *ev = &events[i];
+
+            fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%"PRId64",\"pid\":0,\"tid\":%d",
+                    first ? "" : ",\n", ev->name, ev->phase, ev->ts, buf->tid);
+            if (ev->pts != AV_NOPTS_VALUE)
+                fprintf(f, ",\"args\":{\"pts\":%"PRId64"}", ev->pts);
+            fprintf(f, "}");
+            first = 0;
+        }
+    }
+    fprintf(f, "\n]}\n");
+
+    /* the events of exited threads are exported now, release their buffers */
+    for (TraceBuffer **pbuf = &trace_buffers; *pbuf;) {
+        TraceBuffer *tmp = *pbuf;
+
+        if (tmp->in_use) {
+            pbuf = &tmp->next;
+            continue;
+        }
+
+        *pbuf = tmp->next;
+        av_free(tmp);
+    }
+
+    ff_mutex_unlock(&trace_lock);
+
+    av_free(events);
+
+    ret = ferror(f) ? AVERROR(EIO) : 0;
+    if (fclose(f) && !ret)
+        ret = AVERROR(errno);
+
+    return ret;
+}
+#else
+int av_trace_write_json(const char *filename)
+{
+    return AVERROR(ENOSYS);
+}
+#endif
@@ -0,0 +1,62 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * @ingroup lavu_trace
+ * Public header for exporting internal trace events.
+ */
+
+#ifndef AVUTIL_TRACE_H
+#define AVUTIL_TRACE_H
+
+/**
+ * @defgroup lavu_trace Trace events
+ * @ingroup lavu_misc
+ *
+ * When FFmpeg is configured with --enable-trace-events, the libraries
+ * record begin/end events around decoding, encoding, frame-thread progress
+ * waits, filter activation and scaling passes, together with the calling
+ * thread and the frame timestamp where one is known. Each thread keeps its
+ * events in a fixed-size ring of its own, so only the most recent ones are
+ * retained per thread. The ring of a thread that exits is kept until the next
+ * export and handed over to the next thread that starts recording, so memory
+ * use is bounded by the number of concurrently running threads.
+ *
+ * @{
+ */
+
+/**
+ * Write the recorded trace events to a file, in the Chrome/Perfetto JSON
+ * trace event format.
+ *
+ * This should be called once processing has stopped, events recorded
+ * concurrently with this call may be incomplete. The events of threads that
+ * have exited are discarded after being written.
+ *
+ * @param filename path of the file to write
+ * @return 0 on success, AVERROR(ENOSYS) if FFmpeg was built without
+ *         trace event support, or another negative error code on failure
+ */
+int av_trace_write_json(const char *filename);
+
+/**
+ * @}
+ */
+
+#endif /* AVUTIL_TRACE_H */
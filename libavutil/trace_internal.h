@@ -0,0 +1,44 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_TRACE_INTERNAL_H
+#define AVUTIL_TRACE_INTERNAL_H
+
+#include <stdint.h>
+
+#include "config.h"
+
+/**
+ * Record a trace event for the calling thread.
+ *
+ * @param name  event name, must remain valid for the lifetime of the
+ *              process (e.g. a string literal or a codec/filter name)
+ * @param phase 'B' for the beginning and 'E' for the end of a scope
+ * @param pts   timestamp of the frame being processed, or AV_NOPTS_VALUE
+ */
+void avpriv_trace_event(const char *name, char phase, int64_t pts);
+
+#if CONFIG_TRACE_EVENTS
+#define FF_TRACE_BEGIN(name, pts) avpriv_trace_event(name, 'B', pts)
+#define FF_TRACE_END(name, pts)   avpriv_trace_event(name, 'E', pts)
+#else
+#define FF_TRACE_BEGIN(name, pts) do { } while (0)
+#define FF_TRACE_END(name, pts)   do { } while (0)
+#endif
+
+#endif /* AVUTIL_TRACE_INTERNAL_H */
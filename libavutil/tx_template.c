@@ -851,26 +851,25 @@ static const FFTXCodelet TX_NAME(ff_tx_fft_inplace_def) = {
     .prio       = FF_TX_PRIO_BASE - 512,
 };
 
-static av_cold int TX_NAME(ff_tx_fft_init_naive_small)(AVTXContext *s,
-                                                       const FFTXCodelet *cd,
-                                                       uint64_t flags,
-                                                       FFTXCodeletOptions *opts,
-                                                       int len, int inv,
-                                                       const void *scale)
+static av_cold int TX_NAME(ff_tx_fft_init_naive)(AVTXContext *s,
+                                                 const FFTXCodelet *cd,
+                                                 uint64_t flags,
+                                                 FFTXCodeletOptions *opts,
+                                                 int len, int inv,
+                                                 const void *scale)
 {
     const double phase = s->inv ? 2.0*M_PI/len : -2.0*M_PI/len;
 
-    if (!(s->exp = av_malloc(len*len*sizeof(*s->exp))))
+    /* exp(phase*i*j) only depends on i*j mod len */
+    if (!(s->exp = av_malloc(len*sizeof(*s->exp))))
         return AVERROR(ENOMEM);
 
     for (int i = 0; i < len; i++) {
-        for (int j = 0; j < len; j++) {
-            const double factor = phase*i*j;
-            s->exp[i*j] = (TXComplex){
-                RESCALE(cos(factor)),
-                RESCALE(sin(factor)),
-            };
-        }
+        const double factor = phase*i;
+        s->exp[i] = (TXComplex){
+            RESCALE(cos(factor)),
+            RESCALE(sin(factor)),
+        };
     }
 
     return 0;
@@ -882,63 +881,25 @@ static void TX_NAME(ff_tx_fft_naive)(AVTXContext *s, void *_dst, void *_src,
     TXComplex *src = _src;
     TXComplex *dst = _dst;
     const int n = s->len;
-    double phase = s->inv ? 2.0*M_PI/n : -2.0*M_PI/n;
 
     stride /= sizeof(*dst);
 
     for (int i = 0; i < n; i++) {
         TXComplex tmp = { 0 };
-        for (int j = 0; j < n; j++) {
-            const double factor = phase*i*j;
-            const TXComplex mult = {
-                RESCALE(cos(factor)),
-                RESCALE(sin(factor)),
-            };
+        for (int j = 0, k = 0; j < n; j++) {
             TXComplex res;
+            const TXComplex mult = s->exp[k];
             CMUL3(res, src[j], mult);
             tmp.re += res.re;
             tmp.im += res.im;
+            k += i;
+            if (k >= n)
+                k -= n;
         }
         dst[i*stride] = tmp;
     }
 }
 
-static void TX_NAME(ff_tx_fft_naive_small)(AVTXContext *s, void *_dst, void *_src,
-                                           ptrdiff_t stride)
-{
-    TXComplex *src = _src;
-    TXComplex *dst = _dst;
-    const int n = s->len;
-
-    stride /= sizeof(*dst);
-
-    for (int i = 0; i < n; i++) {
-        TXComplex tmp = { 0 };
-        for (int j = 0; j < n; j++) {
-            TXComplex res;
-            const TXComplex mult = s->exp[i*j];
-            CMUL3(res, src[j], mult);
-            tmp.re += res.re;
-            tmp.im += res.im;
-        }
-        dst[i*stride] = tmp;
-    }
-}
-
-static const FFTXCodelet TX_NAME(ff_tx_fft_naive_small_def) = {
-    .name       = TX_NAME_STR("fft_naive_small"),
-    .function   = TX_NAME(ff_tx_fft_naive_small),
-    .type       = TX_TYPE(FFT),
-    .flags      = AV_TX_UNALIGNED | FF_TX_OUT_OF_PLACE,
-    .factors[0] = TX_FACTOR_ANY,
-    .nb_factors = 1,
-    .min_len    = 2,
-    .max_len    = 1024,
-    .init       = TX_NAME(ff_tx_fft_init_naive_small),
-    .cpu_flags  = FF_TX_CPU_FLAGS_ALL,
-    .prio       = FF_TX_PRIO_MIN/2,
-};
-
 static const FFTXCodelet TX_NAME(ff_tx_fft_naive_def) = {
     .name       = TX_NAME_STR("fft_naive"),
     .function   = TX_NAME(ff_tx_fft_naive),
@@ -948,7 +909,7 @@ static const FFTXCodelet TX_NAME(ff_tx_fft_naive_def) = {
     .nb_factors = 1,
     .min_len    = 2,
     .max_len    = TX_LEN_UNLIMITED,
-    .init       = NULL,
+    .init       = TX_NAME(ff_tx_fft_init_naive),
     .cpu_flags  = FF_TX_CPU_FLAGS_ALL,
     .prio       = FF_TX_PRIO_MIN,
 };
@@ -2185,7 +2146,6 @@ const FFTXCodelet * const TX_NAME(ff_tx_codelet_list)[] = {
     &TX_NAME(ff_tx_fft_pfa_def),
     &TX_NAME(ff_tx_fft_pfa_ns_def),
     &TX_NAME(ff_tx_fft_naive_def),
-    &TX_NAME(ff_tx_fft_naive_small_def),
     &TX_NAME(ff_tx_mdct_fwd_def),
     &TX_NAME(ff_tx_mdct_inv_def),
     &TX_NAME(ff_tx_mdct_pfa_3xM_fwd_def),
@@ -623,23 +623,32 @@ int swri_rematrix(SwrContext *s, AudioData *out, AudioData *in, int len, int mus
                 s->mix_2_1_f   (out->ch[out_i]+off, in->ch[in_i1]+off, in->ch[in_i2]+off, s->native_matrix, in->ch_count*out_i + in_i1, in->ch_count*out_i + in_i2, len-len1);
             break;}
         default:
+            /* Accumulate one input channel at a time, so that each pass is
+             * a contiguous, vectorizable loop; the order of the additions
+             * per sample is the same as summing across channels. */
             if(s->int_sample_fmt == AV_SAMPLE_FMT_FLTP){
-                for(i=0; i<len; i++){
-                    float v=0;
-                    for(j=0; j<s->matrix_ch[out_i][0]; j++){
-                        in_i= s->matrix_ch[out_i][1+j];
-                        v+= ((float*)in->ch[in_i])[i] * s->matrix_flt[out_i][in_i];
-                    }
-                    ((float*)out->ch[out_i])[i]= v;
+                float *dst = (float*)out->ch[out_i];
+                memset(dst, 0, len * sizeof(*dst));
+                for(j=0; j<s->matrix_ch[out_i][0]; j++){
+                    const float *src;
+                    float coeff;
+                    in_i = s->matrix_ch[out_i][1+j];
+                    src  = (const float*)in->ch[in_i];
+                    coeff= s->matrix_flt[out_i][in_i];
+                    for(i=0; i<len; i++)
+                        dst[i] += src[i] * coeff;
                 }
             }else if(s->int_sample_fmt == AV_SAMPLE_FMT_DBLP){
-                for(i=0; i<len; i++){
-                    double v=0;
-                    for(j=0; j<s->matrix_ch[out_i][0]; j++){
-                        in_i= s->matrix_ch[out_i][1+j];
-                        v+= ((double*)in->ch[in_i])[i] * s->matrix[out_i][in_i];
-                    }
-                    ((double*)out->ch[out_i])[i]= v;
+                double *dst = (double*)out->ch[out_i];
+                memset(dst, 0, len * sizeof(*dst));
+                for(j=0; j<s->matrix_ch[out_i][0]; j++){
+                    const double *src;
+                    double coeff;
+                    in_i = s->matrix_ch[out_i][1+j];
+                    src  = (const double*)in->ch[in_i];
+                    coeff= s->matrix[out_i][in_i];
+                    for(i=0; i<len; i++)
+                        dst[i] += src[i] * coeff;
                 }
             }else{
                 for(i=0; i<len; i++){
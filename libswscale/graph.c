@@ -26,6 +26,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/slicethread.h"
+#include "libavutil/trace_internal.h"
 
 #include "libswscale/swscale.h"
 #include "libswscale/format.h"
@@ -613,8 +614,12 @@ int ff_sws_graph_create(SwsContext *ctx, const SwsFormat *dst, const SwsFormat *
     graph->exec.input.fmt  = src->format;
     graph->exec.output.fmt = dst->format;
 
-    ret = avpriv_slicethread_create(&graph->slicethread, (void *) graph,
-                                    sws_graph_worker, NULL, ctx->threads);
+    if (ctx->thread_pool)
+        ret = avpriv_slicethread_create_shared(&graph->slicethread, ctx->thread_pool,
+                                               (void *) graph, sws_graph_worker, ctx->threads);
+    else
+        ret = avpriv_slicethread_create(&graph->slicethread, (void *) graph,
+                                        sws_graph_worker, NULL, ctx->threads);
     if (ret == AVERROR(ENOSYS))
         graph->num_threads = 1;
     else if (ret < 0)
@@ -669,6 +674,7 @@ static int opts_equal(const SwsContext *c1, const SwsContext *c2)
            c1->dst_h_chr_pos == c2->dst_h_chr_pos &&
            c1->dst_v_chr_pos == c2->dst_v_chr_pos &&
            c1->intent        == c2->intent        &&
+           c1->thread_pool   == c2->thread_pool   &&
            !memcmp(c1->scaler_params, c2->scaler_params, sizeof(c1->scaler_params));
 
 }
@@ -712,8 +718,10 @@ void ff_sws_graph_run(SwsGraph *graph, uint8_t *const out_data[4],
     for (int i = 0; i < graph->num_passes; i++) {
         const SwsPass *pass = graph->passes[i];
         graph->exec.pass = pass;
+        FF_TRACE_BEGIN("sws_pass", AV_NOPTS_VALUE);
         if (pass->setup)
             pass->setup(out, in, pass);
         avpriv_slicethread_execute(graph->slicethread, pass->num_slices, 0);
+        FF_TRACE_END("sws_pass", AV_NOPTS_VALUE);
     }
 }
@@ -218,6 +218,7 @@ int ff_sws_lut3d_generate(SwsLut3D *lut3d, enum AVPixelFormat fmt_in,
 
     lut3d->dynamic = map->src.frame_peak.num > 0;
     lut3d->map = *map;
+    lut3d->tone_map_valid = false;
 
     if (lut3d->dynamic) {
         ret = ff_sws_color_map_generate_dynamic(&lut3d->input[0][0][0],
@@ -238,17 +239,30 @@ int ff_sws_lut3d_generate(SwsLut3D *lut3d, enum AVPixelFormat fmt_in,
 
 void ff_sws_lut3d_update(SwsLut3D *lut3d, const SwsColor *new_src)
 {
+    SwsColor *src = &lut3d->map.src;
+
     if (!new_src || !lut3d->dynamic)
         return;
 
-    lut3d->map.src.frame_peak = new_src->frame_peak;
-    lut3d->map.src.frame_avg  = new_src->frame_avg;
+    /* Metadata is often static for a whole scene or stream */
+    if (lut3d->tone_map_valid &&
+        src->frame_peak.num == new_src->frame_peak.num &&
+        src->frame_peak.den == new_src->frame_peak.den &&
+        src->frame_avg.num  == new_src->frame_avg.num  &&
+        src->frame_avg.den  == new_src->frame_avg.den)
+        return;
+
+    src->frame_peak = new_src->frame_peak;
+    src->frame_avg  = new_src->frame_avg;
 
     ff_sws_tone_map_generate(lut3d->tone_map, TONE_LUT_SIZE, &lut3d->map);
+    lut3d->tone_map_valid = true;
 }
 
-void ff_sws_lut3d_apply(const SwsLut3D *lut3d, const uint8_t *in, int in_stride,
-                        uint8_t *out, int out_stride, int w, int h)
+static av_always_inline void apply_lut3d(const SwsLut3D *lut3d,
+                                        const uint8_t *in, int in_stride,
+                                        uint8_t *out, int out_stride,
+                                        int w, int h, const bool dynamic)
 {
     while (h--) {
         const uint16_t *in16 = (const uint16_t *) in;
@@ -258,7 +272,7 @@ void ff_sws_lut3d_apply(const SwsLut3D *lut3d, const uint8_t *in, int in_stride,
             v3u16_t c = { in16[0], in16[1], in16[2] };
             c = lookup_input16(lut3d, c);
 
-            if (lut3d->dynamic) {
+            if (dynamic) {
                 c = apply_tone_map(lut3d, c);
                 c = lookup_output(lut3d, c);
             }
@@ -275,3 +289,12 @@ void ff_sws_lut3d_apply(const SwsLut3D *lut3d, const uint8_t *in, int in_stride,
         out += out_stride;
     }
 }
+
+void ff_sws_lut3d_apply(const SwsLut3D *lut3d, const uint8_t *in, int in_stride,
+                        uint8_t *out, int out_stride, int w, int h)
+{
+    if (lut3d->dynamic)
+        apply_lut3d(lut3d, in, in_stride, out, out_stride, w, h, true);
+    else
+        apply_lut3d(lut3d, in, in_stride, out, out_stride, w, h, false);
+}
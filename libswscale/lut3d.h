@@ -57,6 +57,7 @@ typedef struct SwsLut3D {
 
     /* Split tone mapping LUT (for dynamic tone mapping) */
     v2u16_t tone_map[TONE_LUT_SIZE]; /* new luma, desaturation */
+    bool tone_map_valid; /* tone_map matches map.src frame metadata */
 } SwsLut3D;
 
 SwsLut3D *ff_sws_lut3d_alloc(void);
@@ -84,7 +85,8 @@ int ff_sws_lut3d_generate(SwsLut3D *lut3d, enum AVPixelFormat fmt_in,
 
 /**
  * Update the tone mapping state. This will only use per-frame metadata. The
- * static metadata is ignored.
+ * static metadata is ignored. The tone mapping LUT is only regenerated if
+ * the per-frame metadata actually changed.
  */
 void ff_sws_lut3d_update(SwsLut3D *lut3d, const SwsColor *new_src);
 
@@ -239,6 +239,14 @@ typedef struct SwsContext {
      */
     int intent;
 
+    /**
+     * A reference to an AVThreadPool (see libavutil/threadpool.h) to run
+     * slice threading on, instead of starting threads for this context.
+     * `threads` then limits the number of threads used per slice job.
+     * Owned and freed by libswscale once set.
+     */
+    AVBufferRef *thread_pool;
+
     /* Remember to add new fields to graph.c:opts_equal() */
 } SwsContext;
 
@@ -1834,8 +1834,12 @@ static int context_init_threaded(SwsContext *sws,
     SwsInternal *c = sws_internal(sws);
     int ret;
 
-    ret = avpriv_slicethread_create(&c->slicethread, (void*) sws,
-                                    ff_sws_slice_worker, NULL, sws->threads);
+    if (sws->thread_pool)
+        ret = avpriv_slicethread_create_shared(&c->slicethread, sws->thread_pool, (void*) sws,
+                                               ff_sws_slice_worker, sws->threads);
+    else
+        ret = avpriv_slicethread_create(&c->slicethread, (void*) sws,
+                                        ff_sws_slice_worker, NULL, sws->threads);
     if (ret == AVERROR(ENOSYS)) {
         sws->threads = 1;
         return 0;
@@ -2257,6 +2261,7 @@ void sws_freeContext(SwsContext *sws)
     av_freep(&c->slice_err);
 
     avpriv_slicethread_free(&c->slicethread);
+    av_buffer_unref(&sws->thread_pool);
 
     for (i = 0; i < 4; i++)
         av_freep(&c->dither_error[i]);
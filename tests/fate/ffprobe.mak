@@ -24,4 +24,26 @@ FATE_FFPROBE-$(call FILTERDEMDECENCMUX, AEVALSRC TESTSRC ARESAMPLE, FFMETADATA,
                                         FFMPEG LAVFI_INDEV PCM_F64BE_DECODER PCM_F64LE_DECODER PCM_S16LE_ENCODER) \
                                         += $(FFPROBE_TEST_FILE_TESTS-yes)
 
+# packets read from the MP4 index compared to demuxing: the index has no pts
+# for the reordered video and no skip samples side data for the audio
+tests/data/ffprobe-index.mp4: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+        -f lavfi -i "aevalsrc=sin(400*PI*2*t):d=0.5[out0]; testsrc=d=0.5[out1]" \
+        -flags +bitexact -fflags +bitexact -map 0:0 -map 0:1 \
+        -sws_flags +accurate_rnd+bitexact -c:v mpeg4 -bf 2 -threads 1 -c:a mp2 \
+        -y $(TARGET_PATH)/$@ 2>/dev/null
+
+FFPROBE_INDEX_FILE=tests/data/ffprobe-index.mp4
+FFPROBE_INDEX_COMMAND=ffprobe$(PROGSSUF)$(EXESUF) -show_packets -bitexact -of compact \
+    -show_entries packet=stream_index,pts,dts,duration,size,pos,flags:packet_side_data \
+    $(TARGET_PATH)/$(FFPROBE_INDEX_FILE)
+
+FFPROBE_INDEX_TESTS = fate-ffprobe-index-only fate-ffprobe-index-demux
+$(FFPROBE_INDEX_TESTS): $(FFPROBE_INDEX_FILE)
+fate-ffprobe-index-only:  CMD = run $(FFPROBE_INDEX_COMMAND) -index_only
+fate-ffprobe-index-demux: CMD = run $(FFPROBE_INDEX_COMMAND)
+
+FATE_FFPROBE-$(call FILTERDEMDECENCMUX, AEVALSRC TESTSRC ARESAMPLE, MOV, MPEG4 MP2, MPEG4 MP2, MP4, \
+                                        FFMPEG LAVFI_INDEV) += $(FFPROBE_INDEX_TESTS)
+
 fate-ffprobe: $(FATE_FFPROBE-yes)
@@ -698,6 +698,10 @@ FATE_FILTER_VSYNTH-yes += $(FATE_FILTER_PIXFMTS)
 
 fate-filter-pixfmts: $(FATE_FILTER_PIXFMTS)
 
+FATE-$(CONFIG_DNN) += fate-dnn-io-proc
+fate-dnn-io-proc: libavfilter/tests/dnn_io_proc$(EXESUF)
+fate-dnn-io-proc: CMD = run libavfilter/tests/dnn_io_proc$(EXESUF)
+
 FATE_FILTER_VSYNTH-$(call VIDEO_FILTER) += $(FATE_FILTER_VSYNTH_VIDEO_FILTER-yes)
 FATE_FILTER_VSYNTH-$(call FRAMECRC, IMAGE2, PGMYUV) += $(FATE_FILTER_VSYNTH_PGMYUV-yes)
 $(FATE_FILTER_VSYNTH-yes): $(VREF)